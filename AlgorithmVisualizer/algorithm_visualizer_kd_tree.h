@@ -28,6 +28,7 @@ public slots:
         points.clear();
         elements.clear();
         kdTree->clear();
+        searchTrace.clear();
         referencePointSet = false;
         closestPointFound = false;
     }
@@ -49,8 +50,7 @@ protected:
     virtual void paintEvent(QPaintEvent *event) override{
         QPainter painter(this);
 
-        auto visitedAABBs = visualisationHelper->getVisitedAABBs();
-        for(auto aabb: visitedAABBs){
+        for(auto aabb: searchTrace.visitedAABBs){
             if(aabb.xMin < 0) aabb.xMin=0;
             if(aabb.yMin < 0) aabb.yMin=0;
             if(aabb.xMax > this->width()) aabb.xMax = this->width();
@@ -87,7 +87,7 @@ protected:
     void findClosestElement(){
         if(referencePointSet){
             KDTreeElement element {(float)referencePoint.x(), (float)referencePoint.y()};
-            auto closestElements = kdTree->getElementsClosestTo(&element);
+            auto closestElements = kdTree->getElementsClosestTo(&element,&searchTrace);
 
             if(closestElements.size() > 0){
                 closestPoint = QPoint(closestElements.at(0)->x(),closestElements.at(0)->y());
@@ -96,6 +96,7 @@ protected:
         }
     }
     void sendPointsToKDTree(){
+        elements.clear();
         for(const auto &point: points){
             elements.push_back(KDTreeElement(point.x(),point.y()));
         }
@@ -127,6 +128,8 @@ protected slots:
 protected:
     KDTree *kdTree;
     KDTreeVisualizationHelper *visualisationHelper;
+    //Cells visited by the last closest element search
+    KDTreeSearchTrace searchTrace;
     std::vector<KDTreeElement> elements;
     std::vector<QPoint> points;
     UIPanel uiPanel;
@@ -13,79 +13,44 @@ class AlgorithmVisualizerQuadTree: public AlgorithmVisualizerBase{
         name = "Quad tree";
         initUIPanel();
         initLayout();
+        //Workers are started once and stay asleep while scenes are smaller than holder's parallel cutoff
+        simulation.setThreadsNumber(std::thread::hardware_concurrency());
+        simulation.start();
     }
     void setPoints(vector<QPoint> points){
-        holder.reset();
-        holder.boundingBox = AABB<int>(0,0,this->width(),this->height());
-        holder.addElements(pointsToElements(points));
+        simulation.setElements(pointsToElements(points),AABB<int>(0,0,this->width(),this->height()));
         this->update();
     }
     virtual ~AlgorithmVisualizerQuadTree() override{}
 public slots:
     virtual void reset() override{
-        points.clear();
-        holder.reset();
+        simulation.reset();
     }
     virtual void clear() override{
         reset();
     }
+    virtual void stopResume() override{
+        AlgorithmVisualizerBase::stopResume();
+        simulation.setPaused(!timer->isActive());
+    }
 protected:
     virtual void mousePressEvent(QMouseEvent *mouseEvent) override{
-        bool callUpdate = false;
         std::cout<<mouseEvent->pos().x()<<" "<<mouseEvent->pos().y()<<std::endl;
         if(mouseEvent->buttons() == Qt::RightButton){
-            if(timer->isActive()){
-                timer->stop();
-            }else{
-                timer->start(updateTimeMs);
-            }
-            callUpdate = true;
+            stopResume();
         }else if(mouseEvent->buttons() == Qt::LeftButton){
-            points.push_back(mouseEvent->pos());
-            this->sendPointsToQTree();
-            callUpdate = true;
+            vector<QPoint> points{mouseEvent->pos()};
+            simulation.addElements(pointsToElements(points));
         }
     }
+    virtual void resizeEvent(QResizeEvent *event) override{
+        simulation.setBoundingBox(AABB<int>(0,0,this->width(),this->height()));
+        AlgorithmVisualizerBase::resizeEvent(event);
+    }
+    //Only draws the latest frame, simulation itself runs on its own thread
     virtual void paintEvent(QPaintEvent *event) override{
         QPainter painter(this);
-        sendPointsToQTree();
-
-        //Draw tree
-        for(auto &boundingBox: holder.visualisationHelper->getNonLeafNodesBoundingBoxes()){
-            int xCtr = boundingBox.xMin + (boundingBox.xMax - boundingBox.xMin)/2;
-            int yCtr = boundingBox.yMin + (boundingBox.yMax - boundingBox.yMin)/2;
-            painter.drawLine(boundingBox.xMin,yCtr,boundingBox.xMax,yCtr);
-            painter.drawLine(xCtr,boundingBox.yMin,xCtr,boundingBox.yMax);
-
-        }
-
-        //Draw boxes
-        for(auto element: holder.elementsPtrs){
-            painter.setBrush(QBrush(Qt::cyan));
-            int width = element->aabb.xMax - element->aabb.xMin;
-            int height = element->aabb.yMax - element->aabb.yMin;
-            painter.drawRect(element->aabb.xMin,element->aabb.yMin,width,height);
-        }
-//        for(QPoint point: points){
-//            painter.setBrush(QBrush(Qt::yellow));
-//            painter.drawRect(point.x(),point.y(),quadSide,quadSide);
-//        }
-
-        //Highlight colliding boxes
-        auto overlappingObjects = holder.getOverlappingObjects();
-        for(auto overlappingObject: overlappingObjects){
-            painter.setBrush(QBrush(Qt::red));
-            int width = overlappingObject->aabb.xMax - overlappingObject->aabb.xMin;
-            int height = overlappingObject->aabb.yMax - overlappingObject->aabb.yMin;
-            painter.drawRect(overlappingObject->aabb.xMin,overlappingObject->aabb.yMin,width,height);
-        }
-
-    }
-    void sendPointsToQTree(){
-        holder.update();
-        holder.boundingBox = AABB<int>(0,0,this->width(),this->height());
-        holder.addElements(pointsToElements(points));
-        points.clear();
+        drawQuadTreeFrameSnapshot(painter,simulation.getLatestSnapshot());
     }
     vector<AABB<int>> pointsToElements(vector<QPoint> &points){
         vector<AABB<int>> elements;
@@ -97,10 +62,18 @@ protected:
         return  elements;
     }
     void initUIPanel(){
-        uiPanel.addLineOfWidgets({&randomButton, &randomLabel, &randomLineEdit});
+        initDropdown();
+        uiPanel.addLineOfWidgets({&randomButton, &randomLabel, &randomLineEdit, &dropdown});
         connect(&randomButton, SIGNAL(clicked()), this, SLOT(setRandomData()));
+        connect(&dropdown, SIGNAL(currentIndexChanged(int)), this, SLOT(setQuadTreeType(int)));
         randomLineEdit.setValidator(&randomInputValidator);
     }
+    void initDropdown(){
+        dropdown.addItem("Quad tree fast");
+        dropdown.addItem("Quad tree moderate");
+        dropdown.addItem("STR tree");
+        dropdown.addItem("Dynamic AABB tree");
+    }
     void initLayout(){
         mainLayout.addWidget(&uiPanel,0,0,1,1, Qt::AlignLeft | Qt::AlignTop);
         setLayout(&mainLayout);
@@ -115,16 +88,23 @@ protected slots:
         }
         setPoints(points);
     }
+    void setQuadTreeType(int index){
+        switch(index){
+        case 0: simulation.setQuadTree(new QuadTreeFast<int>()); break;
+        case 1: simulation.setQuadTree(new QuadTreeModerate<int>()); break;
+        case 2: simulation.setQuadTree(new STRTree<int>()); break;
+        case 3: simulation.setQuadTree(new DynamicAABBTree<int>()); break;
+        }
+    }
 
 protected:
 
-    MyCustomElementsHolder holder;
-    int quadSide = 5;
-    vector<QPoint> points;
+    QuadTreeSimulation simulation;
     UIPanel uiPanel;
     QPushButton randomButton{"Random"};
     QLabel randomLabel{"in range from 1 to "};
     QLineEdit randomLineEdit{"55"};
+    QComboBox dropdown;
     QIntValidator randomInputValidator{1, 9999};
 };
 
@@ -1,5 +1,6 @@
 
 CONFIG += c++11 console
+CONFIG += thread
 QT       += core gui
 
 # The following define makes your compiler emit warnings if you use
@@ -26,4 +27,9 @@ SUBDIRS += \
     KDTree.pro
 
 HEADERS += \
-    kd_tree.h
+    kd_tree.h \
+    kd_tree_benchmark.h \
+    kd_tree_implicit.h \
+    kd_tree_generic.h \
+    kd_tree_dynamic.h \
+    kd_tree_searchers.h
@@ -2,12 +2,21 @@
 #define KD_TREE_H
 #include <iostream>
 #include <vector>
-#include <unordered_map>
+#include <array>
+#include <algorithm>
+#include <queue>
+#include <thread>
+#include <cstdint>
+#include <functional>
+#include <iterator>
 #include <cmath>
 #include <limits>
 
 #include <QVector2D>
 
+#include "kd_tree_searchers.h"
+#include "../../QuadTree/QuadTree/quad_tree_parallel.h"
+
 #define FRIEND_TEST(test_case_name, test_name)\
 friend class test_case_name##_##test_name##_Test
 
@@ -15,6 +24,7 @@ friend class test_case_name##_##test_name##_Test
 
 struct KDTreeElement;
 struct KDTreeVisualizationHelper;
+struct KDTreeSearchTrace;
 class KDTreeNode;
 struct AABB_D;
 
@@ -37,23 +47,92 @@ public:
     void setElement(KDTreeElement *element){
         this->element = element;
     }
+    void setSameValueRange(int sameValueBegin, int sameValueCount){
+        this->sameValueBegin = sameValueBegin;
+        this->sameValueCount = sameValueCount;
+    }
     int leftChildId = -1, rightChildId = -1;
     KDTreeElement* element = nullptr;
+    //Range of elements with the same value as element in array of all elements owned by tree
+    int sameValueBegin = 0, sameValueCount = 0;
 };
 
 class KDTree
 {
 public:
     virtual ~KDTree()=default;
-    virtual std::vector<KDTreeElement*> getElementsClosestTo(KDTreeElement* element)=0;
+    //Queries are const and can be called from many threads at once, trace is filled only if given
+    virtual std::vector<KDTreeElement*> getElementsClosestTo(const KDTreeElement* element, KDTreeSearchTrace *trace = nullptr) const=0;
+    //k elements closest to given one sorted by distance, elements with the same value are counted separately
+    virtual std::vector<KDTreeElement*> getKNearest(const KDTreeElement* element, int k, KDTreeSearchTrace *trace = nullptr) const=0;
+    //Appends all elements not further than radius from given one to result
+    virtual void getWithinRadius(const KDTreeElement* element, double radius, std::vector<KDTreeElement*> &result, KDTreeSearchTrace *trace = nullptr) const=0;
     virtual void setNewElements(std::vector<KDTreeElement*> elements)=0;
     virtual void clear()=0;
+    /*
+     * Closest element for every query is written to results at query's index (nullptr for empty tree).
+     * Queries are processed in Morton order of their positions, so consecutive searches go through the same nodes.
+     * If pool is given, the order is split into contiguous chunks processed by its threads, otherwise calling thread does all
+     */
+    void getNearestBatch(const std::vector<KDTreeElement> &queries, std::vector<KDTreeElement*> &results, ParallelForPool *pool = nullptr) const{
+        results.resize(queries.size());
+        int size = queries.size();
+        if(size == 0) return;
+        std::vector<std::pair<uint32_t,int>> order = getMortonOrder(queries);
+        auto processChunk = [&](int begin, int end){
+            for(int i=begin;i<end;i++){
+                int queryId = order[i].second;
+                results[queryId] = getClosestElement(&queries[queryId]);
+            }
+        };
+        if(pool != nullptr){
+            pool->parallelFor(0,size,processChunk);
+        }else{
+            processChunk(0,size);
+        }
+    }
+
+protected:
+    //One of the closest elements or nullptr if tree is empty, used by batch queries
+    virtual KDTreeElement* getClosestElement(const KDTreeElement* element) const{
+        auto closestElements = getElementsClosestTo(element);
+        return closestElements.empty() ? nullptr : closestElements.front();
+    }
+    //Pairs of Morton code and query index sorted by code, codes are computed on 2^16 grid over bounding box of queries
+    static std::vector<std::pair<uint32_t,int>> getMortonOrder(const std::vector<KDTreeElement> &queries){
+        float xMin = std::numeric_limits<float>::max(), yMin = xMin;
+        float xMax = std::numeric_limits<float>::lowest(), yMax = xMax;
+        for(auto &query: queries){
+            xMin = std::min(xMin,query.x());
+            yMin = std::min(yMin,query.y());
+            xMax = std::max(xMax,query.x());
+            yMax = std::max(yMax,query.y());
+        }
+        double xScale = xMax > xMin ? 65535.0 / ((double) xMax - xMin) : 0;
+        double yScale = yMax > yMin ? 65535.0 / ((double) yMax - yMin) : 0;
+        std::vector<std::pair<uint32_t,int>> order(queries.size());
+        for(int i=0;i<queries.size();i++){
+            uint32_t x = static_cast<uint32_t>(((double) queries[i].x() - xMin) * xScale);
+            uint32_t y = static_cast<uint32_t>(((double) queries[i].y() - yMin) * yScale);
+            order[i] = std::make_pair(spreadBits(x) | (spreadBits(y) << 1),i);
+        }
+        std::sort(order.begin(),order.end());
+        return order;
+    }
+    //Puts 16 lower bits of value on even positions
+    static uint32_t spreadBits(uint32_t value){
+        value &= 0xFFFF;
+        value = (value | (value << 8)) & 0x00FF00FF;
+        value = (value | (value << 4)) & 0x0F0F0F0F;
+        value = (value | (value << 2)) & 0x33333333;
+        value = (value | (value << 1)) & 0x55555555;
+        return value;
+    }
 };
 
 struct KDTreeVisualizationHelper{
     virtual ~KDTreeVisualizationHelper(){};
     virtual std::vector<std::pair<std::array<double,4>,int>> getSeparatingLines()=0;
-    virtual std::vector<AABB_D> getVisitedAABBs()=0;
 };
 
 struct AABB_D{
@@ -73,7 +152,7 @@ struct AABB_D{
         }
     }
     static AABB_D biggestAABB(){
-        return  AABB_D(std::numeric_limits<double>::min(),std::numeric_limits<double>::min(),
+        return  AABB_D(std::numeric_limits<double>::lowest(),std::numeric_limits<double>::lowest(),
                     std::numeric_limits<double>::max(),std::numeric_limits<double>::max());
     }
     double minDistanceTo(const KDTreeElement* element) const{
@@ -106,6 +185,14 @@ struct AABB_D{
 };
 
 
+//Cells visited by single query, owned by caller and cleared by every query that gets it
+struct KDTreeSearchTrace{
+    void clear(){
+        visitedAABBs.clear();
+    }
+    std::vector<AABB_D> visitedAABBs;
+};
+
 class KDTreeFirstImpl: public KDTree{
 public:
     KDTreeFirstImpl(){ }
@@ -114,127 +201,318 @@ public:
     }
     virtual ~KDTreeFirstImpl() override{
     }
-    virtual std::vector<KDTreeElement*> getElementsClosestTo(KDTreeElement* element) override{
+    virtual std::vector<KDTreeElement*> getElementsClosestTo(const KDTreeElement* element, KDTreeSearchTrace *trace = nullptr) const override{
         std::vector<KDTreeElement*> nearestElements;
-        visitedAABBs.clear();
+        if(trace != nullptr) trace->clear();
         if(nodes.size()>0){
-            int closestNodeId = -1;
-            double closestDistanceToElement = std::numeric_limits<double>::max();
-            searchForClosestNode(0,AABB_D::biggestAABB(),element,closestNodeId,closestDistanceToElement);
-            auto closestElement = nodes.at(closestNodeId).element;
-            if(sameValueElements.count(closestElement) != 0){
-                nearestElements = sameValueElements.at(closestElement);
-            }else{
-                nearestElements.push_back(closestElement);
-            }
+            KDTreeClosestSearcher<int> searcher(-1);
+            NodeIdSearcher<KDTreeClosestSearcher<int>> nodeSearcher(searcher,approximation);
+            searchNodes(element,nodeSearcher,trace);
+            const auto &closestNode = nodes.at(searcher.closestItem);
+            nearestElements.assign(sortedElements.begin()+closestNode.sameValueBegin,
+                                   sortedElements.begin()+closestNode.sameValueBegin+closestNode.sameValueCount);
         }
         return nearestElements;
     }
+    virtual std::vector<KDTreeElement*> getKNearest(const KDTreeElement* element, int k, KDTreeSearchTrace *trace = nullptr) const override{
+        if(trace != nullptr) trace->clear();
+        if(nodes.empty() || k<=0) return std::vector<KDTreeElement*>();
+        KDTreeKNearestSearcher<KDTreeElement*> searcher(k);
+        SameValueSearcher<KDTreeKNearestSearcher<KDTreeElement*>> nodeSearcher(searcher,sortedElements,approximation);
+        searchNodes(element,nodeSearcher,trace);
+        return searcher.popSorted();
+    }
+    virtual void getWithinRadius(const KDTreeElement* element, double radius, std::vector<KDTreeElement*> &result, KDTreeSearchTrace *trace = nullptr) const override{
+        if(trace != nullptr) trace->clear();
+        if(nodes.size()>0 && radius>=0){
+            //Radius search is exact, so approximation is not applied
+            KDTreeRadiusSearcher<KDTreeElement*> searcher(radius,result);
+            SameValueSearcher<KDTreeRadiusSearcher<KDTreeElement*>> nodeSearcher(searcher,sortedElements,Approximation());
+            searchNodes(element,nodeSearcher,trace);
+        }
+    }
     virtual void setNewElements(std::vector<KDTreeElement*> elements) override{
         clear();
-        sortElements(elements);
-        removeAndHashNonUniqueElements(elements);
-        buildTree(elements.begin(),elements.end());
+        sortElements(elements,buildThreadsNumber);
+        sortedElements = elements;
+        makeSameValueNodes();
+        if(!nodes.empty()) buildNodes(0,nodes.size(),0,buildThreadsNumber);
     }
     virtual void clear() override{
         nodes.clear();
-        sameValueElements.clear();
-        visitedAABBs.clear();
+        sortedElements.clear();
+    }
+    //Tree built with any number of threads is the same as one built serially
+    void setBuildThreadsNumber(int threadsNumber){
+        buildThreadsNumber = std::max(1,threadsNumber);
+    }
+    int getBuildThreadsNumber() const{
+        return buildThreadsNumber;
+    }
+    /*
+     * Makes closest and k nearest searches approximate: node is skipped once (1+epsilon) times its distance is not smaller
+     * than distance to the furthest element searcher keeps, so found elements are at most (1+epsilon) times further than exact ones.
+     * If maxVisitedNodes is positive, search also stops after visiting that many nodes (so k nearest search gives
+     * fewer than k elements if it is smaller than k). Zeros give exact search. Radius search is always exact
+     */
+    void setApproximation(double epsilon, int maxVisitedNodes = 0){
+        approximation.squaredPruneFactor = (1 + std::max(0.0,epsilon)) * (1 + std::max(0.0,epsilon));
+        approximation.maxVisitedNodes = std::max(0,maxVisitedNodes);
     }
 
 protected:
-    void sortElements(std::vector<KDTreeElement*> &elements){
-        std::sort(elements.begin(),elements.end(),[](const KDTreeElement* a,const KDTreeElement* b){
+    virtual KDTreeElement* getClosestElement(const KDTreeElement* element) const override{
+        if(nodes.empty()) return nullptr;
+        KDTreeClosestSearcher<int> searcher(-1);
+        NodeIdSearcher<KDTreeClosestSearcher<int>> nodeSearcher(searcher,approximation);
+        searchNodes(element,nodeSearcher,nullptr);
+        return nodes.at(searcher.closestItem).element;
+    }
+    /*
+     * Elements are sorted by x, y and then address, so order (and which of same value elements is kept in tree) doesn't depend
+     * on threads number. Chunks are sorted in parallel and then merged pairwise, also in parallel
+     */
+    void sortElements(std::vector<KDTreeElement*> &elements, int threadsNumber = 1){
+        auto comparator = [](const KDTreeElement* a,const KDTreeElement* b){
             if(a->x() != b->x()) return a->x() < b->x();
-            else return a->y() < b->y();
+            else if(a->y() != b->y()) return a->y() < b->y();
+            else return std::less<const KDTreeElement*>()(a,b);
+        };
+        int size = elements.size();
+        threadsNumber = std::max(1,std::min(threadsNumber,size/PARALLEL_BUILD_MIN_SIZE));
+        if(threadsNumber == 1){
+            std::sort(elements.begin(),elements.end(),comparator);
+            return;
+        }
+        std::vector<int> bounds;
+        for(int i=0;i<=threadsNumber;i++){
+            bounds.push_back((long long) size * i / threadsNumber);
+        }
+        runInParallel(threadsNumber,[&](int chunkId){
+            std::sort(elements.begin()+bounds.at(chunkId),elements.begin()+bounds.at(chunkId+1),comparator);
         });
+        for(int step=1;step<threadsNumber;step*=2){
+            runInParallel((threadsNumber + 2*step - 1)/(2*step),[&](int mergeId){
+                int begin = mergeId*2*step;
+                int middle = std::min(begin+step,threadsNumber);
+                int end = std::min(begin+2*step,threadsNumber);
+                std::inplace_merge(elements.begin()+bounds.at(begin),elements.begin()+bounds.at(middle),
+                                   elements.begin()+bounds.at(end),comparator);
+            });
+        }
+    }
+    //One node for every run of elements with the same value in sortedElements
+    void makeSameValueNodes(){
+        for(int begin=0,end=0;begin<sortedElements.size();begin=end){
+            while(end<sortedElements.size() && *sortedElements[end] == *sortedElements[begin]) end++;
+            KDTreeNode node(sortedElements[begin]);
+            node.setSameValueRange(begin,end-begin);
+            nodes.push_back(node);
+        }
+    }
+    /*
+     * Nodes [firstId,lastId) are rearranged in place into subtree stored in preorder: median is swapped to firstId,
+     * so its left subtree takes next (lastId-firstId)/2 ids and right subtree the rest. As ids of subtree's nodes follow
+     * from its range, subtrees can be built by separate threads
+     */
+    void buildNodes(int firstId, int lastId, unsigned iteration, int threadsNumber){
+        int size = lastId - firstId;
+        if(size == 1){
+            nodes.at(firstId).setChildren(-1,-1);
+            return;
+        }
+        //Ties are broken by other coordinate, elements of nodes are unique so median and both halves are unique too
+        auto comparator = [iteration](const KDTreeNode &a,const KDTreeNode &b){
+            if(iteration%2 == 0) return a.element->x() < b.element->x() || (a.element->x() == b.element->x() && a.element->y() < b.element->y());
+            else return a.element->y() < b.element->y() || (a.element->y() == b.element->y() && a.element->x() < b.element->x());
+        };
+        auto first = nodes.begin() + firstId;
+        auto middle = first + size/2;
+        selectMedian(first,middle,nodes.begin() + lastId,comparator,threadsNumber);
+        std::iter_swap(first,middle);
+        int leftSize = size/2;
+        int leftChildId = leftSize > 0 ? firstId + 1 : -1;
+        int rightChildId = firstId + 1 + leftSize < lastId ? firstId + 1 + leftSize : -1;
+        nodes.at(firstId).setChildren(leftChildId,rightChildId);
+        if(threadsNumber > 1 && size >= PARALLEL_BUILD_MIN_SIZE){
+            std::thread leftThread([=](){
+                if(leftChildId != -1) buildNodes(leftChildId,leftChildId + leftSize,iteration+1,threadsNumber/2);
+            });
+            if(rightChildId != -1) buildNodes(rightChildId,lastId,iteration+1,threadsNumber - threadsNumber/2);
+            leftThread.join();
+        }else{
+            if(leftChildId != -1) buildNodes(leftChildId,leftChildId + leftSize,iteration+1,1);
+            if(rightChildId != -1) buildNodes(rightChildId,lastId,iteration+1,1);
+        }
     }
-    void removeAndHashNonUniqueElements(std::vector<KDTreeElement*> &elements){
-        if(elements.size() > 1){
-            std::vector<KDTreeElement*> sameElements,uniqueElements;
-            KDTreeElement* prevElement = nullptr;
-            auto hashSameElementsIfNeeded = [&](){
-                if(sameElements.size() > 1){
-                    sameValueElements.insert({prevElement,sameElements});
-                }
-                uniqueElements.push_back(prevElement);
-                sameElements.clear();
-            };
+    /*
+     * Same as std::nth_element, but while range is big, it is narrowed with parallel partitions around pivot
+     * that is median of evenly spaced samples. Every thread partitions its chunk in place, then chunks' parts are
+     * gathered into buffer so that all elements less than pivot go first
+     */
+    template <class IT, class COMPARATOR>
+    void selectMedian(IT first, const IT middle, IT last, COMPARATOR comparator, int threadsNumber){
+        typedef typename std::iterator_traits<IT>::value_type VALUE;
+        std::vector<VALUE> buffer;
+        while(threadsNumber > 1 && std::distance(first,last) >= PARALLEL_BUILD_MIN_SIZE){
+            int size = std::distance(first,last);
+            std::vector<VALUE> samples;
+            for(int i=0;i<PIVOT_SAMPLES_NUMBER;i++){
+                samples.push_back(*std::next(first,(long long) size * i / PIVOT_SAMPLES_NUMBER));
+            }
+            std::nth_element(samples.begin(),samples.begin()+PIVOT_SAMPLES_NUMBER/2,samples.end(),comparator);
+            VALUE pivot = samples.at(PIVOT_SAMPLES_NUMBER/2);
 
-            for(int i=0;i<elements.size();i++){
-                auto currElement = elements.at(i);
-                if(prevElement != nullptr){
-                    if(*currElement != *prevElement){
-                        hashSameElementsIfNeeded();
-                    }
-                }
-                prevElement = currElement;
-                sameElements.push_back(currElement);
+            std::vector<int> bounds, lessNumbers(threadsNumber), lessOffsets(threadsNumber), greaterOffsets(threadsNumber);
+            for(int i=0;i<=threadsNumber;i++){
+                bounds.push_back((long long) size * i / threadsNumber);
+            }
+            runInParallel(threadsNumber,[&](int chunkId){
+                auto chunkMiddle = std::partition(first+bounds.at(chunkId),first+bounds.at(chunkId+1),[&](const VALUE &value){
+                    return comparator(value,pivot);
+                });
+                lessNumbers.at(chunkId) = std::distance(first+bounds.at(chunkId),chunkMiddle);
+            });
+            int lessNumber = 0, greaterNumber = 0;
+            for(int i=0;i<threadsNumber;i++){
+                lessOffsets.at(i) = lessNumber;
+                greaterOffsets.at(i) = greaterNumber;
+                lessNumber += lessNumbers.at(i);
+                greaterNumber += bounds.at(i+1) - bounds.at(i) - lessNumbers.at(i);
             }
-            hashSameElementsIfNeeded();
-            elements = uniqueElements;
+            //Pivot is in range and is not less than itself, so range can only stay the same if pivot is the smallest
+            if(lessNumber == 0) break;
+            buffer.resize(size);
+            runInParallel(threadsNumber,[&](int chunkId){
+                auto chunkBegin = first+bounds.at(chunkId);
+                auto chunkMiddle = chunkBegin+lessNumbers.at(chunkId);
+                std::copy(chunkBegin,chunkMiddle,buffer.begin()+lessOffsets.at(chunkId));
+                std::copy(chunkMiddle,first+bounds.at(chunkId+1),buffer.begin()+lessNumber+greaterOffsets.at(chunkId));
+            });
+            runInParallel(threadsNumber,[&](int chunkId){
+                std::copy(buffer.begin()+bounds.at(chunkId),buffer.begin()+bounds.at(chunkId+1),first+bounds.at(chunkId));
+            });
+            if(std::distance(first,middle) < lessNumber) last = first+lessNumber;
+            else first = first+lessNumber;
+        }
+        std::nth_element(first,middle,last,comparator);
+    }
+    //Calls function(taskId) for every task id in [0,tasksNumber), each on its own thread
+    template <class F>
+    static void runInParallel(int tasksNumber, F function){
+        std::vector<std::thread> threads;
+        for(int taskId=1;taskId<tasksNumber;taskId++){
+            threads.push_back(std::thread(function,taskId));
+        }
+        if(tasksNumber > 0) function(0);
+        for(auto &thread: threads){
+            thread.join();
         }
     }
-    using ITERATOR = std::vector<KDTreeElement*>::iterator;
-    int buildTree(const ITERATOR first, const ITERATOR last, unsigned iteration = 0){
-        if(first==last) return -1;
-        auto distance = std::distance(first,last);
-        auto middle = std::next(first,distance/2);
-        int nodeId = makeNode();
-        if(std::next(first) != last){
-            auto comparator = [iteration](const KDTreeElement* a,const KDTreeElement* b){
-                if(iteration%2 == 0) return a->x() < b->x();
-                else return a->y() < b->y();
-            };
-            std::nth_element(first,middle,last,comparator);
-            int leftChildId = buildTree(first,middle,iteration+1);
-            int rightChildId = buildTree(std::next(middle),last,iteration+1);
-            nodes.at(nodeId).setChildren(leftChildId,rightChildId);
+    struct Approximation{
+        bool isExhausted(int visitedNodes) const{
+            return maxVisitedNodes > 0 && visitedNodes >= maxVisitedNodes;
         }
-        nodes.at(nodeId).setElement(*middle);
-        return nodeId;
-    }
-    void searchForClosestNode(int currNodeId,const AABB_D &currNodeAABB, KDTreeElement *element,int &closestNodeId, double &closestDistanceToElement, int iteration=0){
-        double minPossibleDistanceToElement = currNodeAABB.minDistanceTo(element);
-        if(minPossibleDistanceToElement < closestDistanceToElement && currNodeId != -1){
-            visitedAABBs.push_back(currNodeAABB);
-            auto currNode = nodes.at(currNodeId);
-            auto currDistanceToElement = (*currNode.element - *element).length();
-            if(currDistanceToElement < closestDistanceToElement){
-                closestNodeId = currNodeId;
-                closestDistanceToElement = currDistanceToElement;
+        double squaredPruneFactor = 1;
+        int maxVisitedNodes = 0;
+    };
+    /*
+     * Node searchers adapt searchers of kd_tree_searchers.h to nodes: searchNodes calls visit(nodeId, node, squaredDistance)
+     * for every node whose bounding box passed isWorthVisiting. Pruning distance is scaled by approximation and
+     * search stops after visiting approximation's maxVisitedNodes. This one passes node ids to searcher
+     */
+    template <class SEARCHER>
+    struct NodeIdSearcher{
+        NodeIdSearcher(SEARCHER &searcher, const Approximation &approximation):
+            searcher(searcher),approximation(approximation){}
+        bool isWorthVisiting(double minPossibleSquaredDistance) const{
+            return !approximation.isExhausted(visitedNodes) &&
+                   searcher.isWorthVisiting(minPossibleSquaredDistance * approximation.squaredPruneFactor);
+        }
+        void visit(int nodeId, const KDTreeNode &, double squaredDistance){
+            visitedNodes++;
+            searcher.visit(nodeId,squaredDistance);
+        }
+        SEARCHER &searcher;
+        Approximation approximation;
+        int visitedNodes = 0;
+    };
+    //Passes every element with node's value to searcher, so elements with the same value are counted separately
+    template <class SEARCHER>
+    struct SameValueSearcher{
+        SameValueSearcher(SEARCHER &searcher, const std::vector<KDTreeElement*> &sortedElements, const Approximation &approximation):
+            searcher(searcher),sortedElements(sortedElements),approximation(approximation){}
+        bool isWorthVisiting(double minPossibleSquaredDistance) const{
+            return !approximation.isExhausted(visitedNodes) &&
+                   searcher.isWorthVisiting(minPossibleSquaredDistance * approximation.squaredPruneFactor);
+        }
+        void visit(int, const KDTreeNode &node, double squaredDistance){
+            visitedNodes++;
+            //Unique element is not looked up in sortedElements to avoid extra cache miss
+            if(node.sameValueCount == 1){
+                searcher.visit(node.element,squaredDistance);
+                return;
             }
-            auto aabbs = currNodeAABB.split(iteration,currNode.element);
-            if(currNode.leftChildId != -1 && currNode.rightChildId != -1){
-                auto leftChildDistanceToElement = (*nodes.at(currNode.leftChildId).element - *element).length();
-                auto rightChildDistanceToElement = (*nodes.at(currNode.rightChildId).element - *element).length();
-                if(leftChildDistanceToElement < rightChildDistanceToElement){
-                    searchForClosestNode(currNode.leftChildId,aabbs.at(0),element,closestNodeId,closestDistanceToElement,iteration+1);
-                    searchForClosestNode(currNode.rightChildId,aabbs.at(1),element,closestNodeId,closestDistanceToElement,iteration+1);
-                }else{
-                    searchForClosestNode(currNode.rightChildId,aabbs.at(1),element,closestNodeId,closestDistanceToElement,iteration+1);
-                    searchForClosestNode(currNode.leftChildId,aabbs.at(0),element,closestNodeId,closestDistanceToElement,iteration+1);
-                }
-            }else if(currNode.leftChildId != -1){
-                searchForClosestNode(currNode.leftChildId,aabbs.at(0),element,closestNodeId,closestDistanceToElement,iteration+1);
-            }else if(currNode.rightChildId != -1){
-                searchForClosestNode(currNode.rightChildId,aabbs.at(1),element,closestNodeId,closestDistanceToElement,iteration+1);
+            for(int i=node.sameValueBegin;i<node.sameValueBegin+node.sameValueCount;i++){
+                searcher.visit(sortedElements[i],squaredDistance);
             }
         }
+        SEARCHER &searcher;
+        const std::vector<KDTreeElement*> &sortedElements;
+        Approximation approximation;
+        int visitedNodes = 0;
+    };
+    template <class SEARCHER>
+    void searchNodes(const KDTreeElement *element, SEARCHER &searcher, KDTreeSearchTrace *trace) const{
+        std::array<double,2> offsets = {0,0};
+        searchNodes(0,element->x(),element->y(),offsets,0,searcher,AABB_D::biggestAABB(),trace,0);
     }
-    int makeNode(){
-        auto nodeId = nodes.size();
-        nodes.push_back(KDTreeNode());
-        return nodeId;
+    /*
+     * offsets hold distance from element to node's bounding box along every axis and squaredBoxDistance is sum of their squares.
+     * Child on element's side of splitting line is searched first and has the same box distance, the other child differs only
+     * in offset along splitting axis, so its box distance is updated from it without computing bounding box.
+     * Bounding boxes are tracked only when trace is given
+     */
+    template <class SEARCHER>
+    void searchNodes(int currNodeId, double x, double y, std::array<double,2> &offsets, double squaredBoxDistance,
+                     SEARCHER &searcher, const AABB_D &currNodeAABB, KDTreeSearchTrace *trace, unsigned iteration) const{
+        if(currNodeId == -1 || !searcher.isWorthVisiting(squaredBoxDistance)) return;
+        if(trace != nullptr) trace->visitedAABBs.push_back(currNodeAABB);
+        const auto &currNode = nodes[currNodeId];
+        double dx = x - currNode.element->x();
+        double dy = y - currNode.element->y();
+        searcher.visit(currNodeId,currNode,dx*dx + dy*dy);
+        int axis = iteration%2;
+        double difference = axis == 0 ? dx : dy;
+        int nearChildId = difference < 0 ? currNode.leftChildId : currNode.rightChildId;
+        int farChildId = difference < 0 ? currNode.rightChildId : currNode.leftChildId;
+        std::array<AABB_D,2> aabbs;
+        if(trace != nullptr) aabbs = currNodeAABB.split(iteration,currNode.element);
+        const AABB_D &nearAABB = difference < 0 ? aabbs[0] : aabbs[1];
+        const AABB_D &farAABB = difference < 0 ? aabbs[1] : aabbs[0];
+        searchNodes(nearChildId,x,y,offsets,squaredBoxDistance,searcher,nearAABB,trace,iteration+1);
+        if(farChildId != -1){
+            double prevOffset = offsets[axis];
+            offsets[axis] = difference;
+            searchNodes(farChildId,x,y,offsets,squaredBoxDistance - prevOffset*prevOffset + difference*difference,
+                        searcher,farAABB,trace,iteration+1);
+            offsets[axis] = prevOffset;
+        }
     }
 protected:
     friend class KDTreeFirstImplVisualizationHelper;
     FRIEND_TEST(KDTreeFirstImpl,sortElements);
-    FRIEND_TEST(KDTreeFirstImpl,removeAndHashNonUniqueElements);
-    FRIEND_TEST(KDTreeFirstImpl,buildTree);
+    FRIEND_TEST(KDTreeFirstImpl,makeSameValueNodes);
+    FRIEND_TEST(KDTreeFirstImpl,buildNodes);
+    FRIEND_TEST(KDTreeFirstImpl,parallelBuild);
+    //Ranges smaller than that are sorted, partitioned and built on one thread
+    static const int PARALLEL_BUILD_MIN_SIZE = 1<<16;
+    static const int PIVOT_SAMPLES_NUMBER = 63;
+    int buildThreadsNumber = 1;
+    Approximation approximation;
     std::vector<KDTreeNode> nodes;
-    std::unordered_map<KDTreeElement*,std::vector<KDTreeElement*>> sameValueElements;
-    std::vector<AABB_D> visitedAABBs;
+    //All elements sorted by value, so elements with the same value form contiguous run
+    std::vector<KDTreeElement*> sortedElements;
 };
 
 struct KDTreeFirstImplVisualizationHelper: public KDTreeVisualizationHelper{
@@ -247,9 +525,6 @@ struct KDTreeFirstImplVisualizationHelper: public KDTreeVisualizationHelper{
         }
         return result;
     }
-    virtual std::vector<AABB_D> getVisitedAABBs() override{
-        return kdTree->visitedAABBs;
-    }
 protected:
     void iterateOverKDTree(int currNodeId, AABB_D aabb,std::vector<std::pair<std::array<double,4>,int>> &lineData, int iteration=0){
         if(currNodeId==-1) return;
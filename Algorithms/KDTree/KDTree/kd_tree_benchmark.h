@@ -0,0 +1,350 @@
+#ifndef KD_TREE_BENCHMARK_H
+#define KD_TREE_BENCHMARK_H
+#include <ctime>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "kd_tree.h"
+#include "kd_tree_dynamic.h"
+#include "kd_tree_implicit.h"
+
+class KDTreeDataGenerator{
+public:
+    KDTreeDataGenerator(){
+        srand(time(0));
+    }
+    std::vector<KDTreeElement> makeElements(int numberOfElements, const AABB_D &boundingBox = AABB_D(0,0,800,800)){
+        std::vector<KDTreeElement> elements(numberOfElements);
+        for(int i=0;i<numberOfElements;i++){
+            float x = boundingBox.xMin + (boundingBox.xMax - boundingBox.xMin) * rand() / RAND_MAX;
+            float y = boundingBox.yMin + (boundingBox.yMax - boundingBox.yMin) * rand() / RAND_MAX;
+            elements.at(i) = KDTreeElement(x,y);
+        }
+        return elements;
+    }
+};
+
+class KDTreeBenchmark{
+public:
+    /*
+     * For every k tree getKNearest is compared with brute force that sorts distances to all elements
+     * with std::partial_sort. Distances of found elements are checked against brute force ones
+     */
+    void compareKNearestWithBruteForce(KDTree *kdTree,
+                                       int numberOfElements,
+                                       int numberOfQueries,
+                                       const std::vector<int> &ks = {1,2,4,8,16,32,64},
+                                       const AABB_D &boundingBox = AABB_D(0,0,800,800)) const
+    {
+        KDTreeDataGenerator generator;
+        std::vector<KDTreeElement> elements = generator.makeElements(numberOfElements,boundingBox);
+        std::vector<KDTreeElement> queries = generator.makeElements(numberOfQueries,boundingBox);
+        std::vector<KDTreeElement*> elementsPtrs = toPtrs(elements);
+        std::cout<<"Comparing getKNearest with brute force on "<<numberOfElements<<" elements and "<<numberOfQueries<<" queries..."<<std::endl;
+        kdTree->setNewElements(elementsPtrs);
+
+        for(int k: ks){
+            std::vector<std::vector<KDTreeElement*>> treeResults(queries.size());
+            std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+            for(int i=0;i<queries.size();i++){
+                treeResults.at(i) = kdTree->getKNearest(&queries.at(i),k);
+            }
+            std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+            std::vector<std::vector<double>> bruteForceDistances(queries.size());
+            std::vector<double> distances(elementsPtrs.size());
+            for(int i=0;i<queries.size();i++){
+                for(int j=0;j<elementsPtrs.size();j++){
+                    distances.at(j) = (*elementsPtrs.at(j) - queries.at(i)).length();
+                }
+                int nearestNumber = std::min<int>(k,distances.size());
+                std::partial_sort(distances.begin(),distances.begin()+nearestNumber,distances.end());
+                bruteForceDistances.at(i).assign(distances.begin(),distances.begin()+nearestNumber);
+            }
+            std::chrono::high_resolution_clock::time_point t3 = std::chrono::high_resolution_clock::now();
+
+            int mismatches = 0;
+            for(int i=0;i<queries.size();i++){
+                std::vector<double> treeDistances;
+                for(auto element: treeResults.at(i)){
+                    treeDistances.push_back((*element - queries.at(i)).length());
+                }
+                if(treeDistances != bruteForceDistances.at(i)) mismatches++;
+            }
+            auto treeMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+            auto bruteForceMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(t3 - t2).count();
+            std::cout<<"k = "<<k<<": tree "<<(double) treeMicroseconds/queries.size()<<" us per query, brute force "<<
+                       (double) bruteForceMicroseconds/queries.size()<<" us per query, speedup "<<
+                       (double) bruteForceMicroseconds/std::max<long long>(treeMicroseconds,1)<<
+                       (mismatches == 0 ? "" : ", MISMATCHES: " + std::to_string(mismatches))<<std::endl;
+        }
+    }
+    //Average time and number of found elements of getWithinRadius for every radius
+    void testWithinRadius(KDTree *kdTree,
+                          int numberOfElements,
+                          int numberOfQueries,
+                          const std::vector<double> &radiuses = {1,5,20,50},
+                          const AABB_D &boundingBox = AABB_D(0,0,800,800)) const
+    {
+        KDTreeDataGenerator generator;
+        std::vector<KDTreeElement> elements = generator.makeElements(numberOfElements,boundingBox);
+        std::vector<KDTreeElement> queries = generator.makeElements(numberOfQueries,boundingBox);
+        std::vector<KDTreeElement*> elementsPtrs = toPtrs(elements);
+        std::cout<<"Performing getWithinRadius test on "<<numberOfElements<<" elements with "<<numberOfQueries<<" queries..."<<std::endl;
+        kdTree->setNewElements(elementsPtrs);
+
+        std::vector<KDTreeElement*> result;
+        for(double radius: radiuses){
+            long long foundElements = 0;
+            std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+            for(auto &query: queries){
+                result.clear();
+                kdTree->getWithinRadius(&query,radius,result);
+                foundElements += result.size();
+            }
+            std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+            auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+            std::cout<<"radius = "<<radius<<": "<<(double) microseconds/queries.size()<<" us per query, "<<
+                       (double) foundElements/queries.size()<<" elements per query"<<std::endl;
+        }
+    }
+
+    /*
+     * getNearestBatch with every number of threads compared with calling getElementsClosestTo for every query
+     * in input order, speedup is reported relative to those single calls
+     */
+    void testNearestBatchScaling(KDTree *kdTree,
+                                 int numberOfElements,
+                                 int numberOfQueries,
+                                 const std::vector<int> &threadsNumbers = {1,2,4,8},
+                                 const AABB_D &boundingBox = AABB_D(0,0,800,800)) const
+    {
+        KDTreeDataGenerator generator;
+        std::vector<KDTreeElement> elements = generator.makeElements(numberOfElements,boundingBox);
+        std::vector<KDTreeElement> queries = generator.makeElements(numberOfQueries,boundingBox);
+        std::vector<KDTreeElement*> elementsPtrs = toPtrs(elements);
+        std::cout<<"Performing batch nearest test on "<<numberOfElements<<" elements with "<<numberOfQueries<<" queries..."<<std::endl;
+        kdTree->setNewElements(elementsPtrs);
+
+        std::vector<KDTreeElement*> singleResults(queries.size());
+        std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+        for(int i=0;i<queries.size();i++){
+            singleResults.at(i) = kdTree->getElementsClosestTo(&queries.at(i)).front();
+        }
+        std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+        auto singleMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+        std::cout<<"single queries: "<<singleMicroseconds/1000.0<<" ms"<<std::endl;
+
+        std::vector<KDTreeElement*> batchResults;
+        for(int threadsNumber: threadsNumbers){
+            //Pool is started before timing, so only waking up its threads is measured
+            ParallelForPool pool(threadsNumber);
+            std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+            kdTree->getNearestBatch(queries,batchResults,&pool);
+            std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+            auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+            int mismatches = 0;
+            for(int i=0;i<queries.size();i++){
+                if(*batchResults.at(i) != *singleResults.at(i)) mismatches++;
+            }
+            std::cout<<threadsNumber<<" threads: "<<microseconds/1000.0<<" ms, speedup "<<
+                       (double) singleMicroseconds/std::max<long long>(microseconds,1)<<
+                       (mismatches == 0 ? "" : ", MISMATCHES: " + std::to_string(mismatches))<<std::endl;
+        }
+    }
+
+    //Time of setNewElements for every number of elements and every number of build threads
+    void testBuildScaling(KDTreeFirstImpl *kdTree,
+                          const std::vector<int> &elementsNumbers = {1000000,10000000,50000000},
+                          const std::vector<int> &threadsNumbers = {1,2,4,8},
+                          const AABB_D &boundingBox = AABB_D(0,0,800,800)) const
+    {
+        KDTreeDataGenerator generator;
+        int initialThreadsNumber = kdTree->getBuildThreadsNumber();
+        for(int numberOfElements: elementsNumbers){
+            std::vector<KDTreeElement> elements = generator.makeElements(numberOfElements,boundingBox);
+            std::vector<KDTreeElement*> elementsPtrs = toPtrs(elements);
+            std::cout<<"Building tree of "<<numberOfElements<<" elements..."<<std::endl;
+            for(int threadsNumber: threadsNumbers){
+                kdTree->clear();
+                kdTree->setBuildThreadsNumber(threadsNumber);
+                std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+                kdTree->setNewElements(elementsPtrs);
+                std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+                auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+                std::cout<<threadsNumber<<" threads: "<<microseconds/1000.0<<" ms"<<std::endl;
+            }
+            kdTree->clear();
+        }
+        kdTree->setBuildThreadsNumber(initialThreadsNumber);
+    }
+
+    /*
+     * Starting from tree of numberOfElements elements, numberOfOperations operations are performed, each of them is
+     * insert of new element with probability insertShare and closest element query otherwise. Time per operation
+     * is compared with KDTreeFirstImpl rebuilt by setNewElements after every insert
+     */
+    void testMixedInsertAndQuery(KDTreeDynamic *kdTree,
+                                 int numberOfElements,
+                                 int numberOfOperations,
+                                 const std::vector<double> &insertShares = {0.1,0.5,0.9},
+                                 const AABB_D &boundingBox = AABB_D(0,0,800,800)) const
+    {
+        KDTreeDataGenerator generator;
+        std::vector<KDTreeElement> elements = generator.makeElements(numberOfElements + numberOfOperations,boundingBox);
+        std::vector<KDTreeElement> queries = generator.makeElements(numberOfOperations,boundingBox);
+        std::vector<KDTreeElement*> elementsPtrs = toPtrs(elements);
+        std::vector<KDTreeElement*> initialElementsPtrs(elementsPtrs.begin(),elementsPtrs.begin()+numberOfElements);
+        std::cout<<"Performing mixed insert and query test on "<<numberOfElements<<" elements with "<<numberOfOperations<<" operations..."<<std::endl;
+
+        KDTreeFirstImpl staticKDTree(initialElementsPtrs);
+        int rebuildsNumber = std::min(numberOfOperations,20);
+        std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+        for(int i=0;i<rebuildsNumber;i++){
+            staticKDTree.setNewElements(std::vector<KDTreeElement*>(elementsPtrs.begin(),elementsPtrs.begin()+numberOfElements+i+1));
+        }
+        std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+        double rebuildMicroseconds = (double) std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count() / std::max(rebuildsNumber,1);
+        std::cout<<"rebuilding KDTreeFirstImpl: "<<rebuildMicroseconds<<" us per insert"<<std::endl;
+
+        for(double insertShare: insertShares){
+            kdTree->setNewElements(initialElementsPtrs);
+            int insertsNumber = 0;
+            long long checksum = 0;
+            std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+            for(int i=0;i<numberOfOperations;i++){
+                if((double) rand() / RAND_MAX < insertShare){
+                    kdTree->insert(elementsPtrs.at(numberOfElements + insertsNumber++));
+                }else{
+                    checksum += kdTree->getElementsClosestTo(&queries.at(i)).size();
+                }
+            }
+            std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+            auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+            std::cout<<"insert share "<<insertShare<<": "<<(double) microseconds/numberOfOperations<<" us per operation, "<<
+                       insertsNumber<<" inserts, "<<kdTree->getLevelsNumber()<<" levels, checksum "<<checksum<<std::endl;
+        }
+    }
+
+    /*
+     * getKNearest with every epsilon and cap on visited nodes compared with exact search. Recall is share of found elements
+     * that are not further than k-th exact one, speedup is relative to exact search
+     */
+    void testApproximation(KDTreeFirstImpl *kdTree,
+                           int numberOfElements,
+                           int numberOfQueries,
+                           const std::vector<double> &epsilons = {0,0.1,0.5,1},
+                           const std::vector<int> &maxVisitedNodesNumbers = {0,64},
+                           const std::vector<int> &ks = {1,8},
+                           const AABB_D &boundingBox = AABB_D(0,0,800,800)) const
+    {
+        KDTreeDataGenerator generator;
+        std::vector<KDTreeElement> elements = generator.makeElements(numberOfElements,boundingBox);
+        std::vector<KDTreeElement> queries = generator.makeElements(numberOfQueries,boundingBox);
+        std::vector<KDTreeElement*> elementsPtrs = toPtrs(elements);
+        std::cout<<"Performing approximate search test on "<<numberOfElements<<" elements with "<<numberOfQueries<<" queries..."<<std::endl;
+        kdTree->setNewElements(elementsPtrs);
+
+        for(int k: ks){
+            std::vector<std::vector<KDTreeElement*>> results(queries.size());
+            auto runQueries = [&](){
+                std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+                for(int i=0;i<queries.size();i++){
+                    results.at(i) = kdTree->getKNearest(&queries.at(i),k);
+                }
+                std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+                return std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+            };
+            kdTree->setApproximation(0);
+            //First run only warms up caches
+            runQueries();
+            auto exactMicroseconds = runQueries();
+            std::vector<double> kthExactDistances;
+            for(int i=0;i<queries.size();i++){
+                kthExactDistances.push_back((*results.at(i).back() - queries.at(i)).length());
+            }
+            for(int maxVisitedNodes: maxVisitedNodesNumbers){
+                for(double epsilon: epsilons){
+                    kdTree->setApproximation(epsilon,maxVisitedNodes);
+                    auto microseconds = runQueries();
+                    long long foundNumber = 0, correctNumber = 0;
+                    for(int i=0;i<queries.size();i++){
+                        for(auto element: results.at(i)){
+                            if((*element - queries.at(i)).length() <= kthExactDistances.at(i)) correctNumber++;
+                        }
+                        foundNumber += results.at(i).size();
+                    }
+                    std::cout<<"k = "<<k<<", epsilon = "<<epsilon<<", max visited nodes = "<<maxVisitedNodes<<": "<<
+                               (double) microseconds/queries.size()<<" us per query, speedup "<<
+                               (double) exactMicroseconds/std::max<long long>(microseconds,1)<<", recall "<<
+                               (double) correctNumber/((long long) k*queries.size())<<", found "<<
+                               (double) foundNumber/queries.size()<<" elements per query"<<std::endl;
+                }
+            }
+        }
+        kdTree->setApproximation(0);
+    }
+
+    /*
+     * buildKNNGraph with every number of threads compared with getKNearest(k+1) called for every element,
+     * distances of neighbours are checked against those of naive loop
+     */
+    void testKNNGraph(KDTreeImplicit *kdTree,
+                      int numberOfElements,
+                      const std::vector<int> &ks = {1,8,16},
+                      const std::vector<int> &threadsNumbers = {1,2,4,8},
+                      const AABB_D &boundingBox = AABB_D(0,0,800,800)) const
+    {
+        KDTreeDataGenerator generator;
+        std::vector<KDTreeElement> elements = generator.makeElements(numberOfElements,boundingBox);
+        std::vector<KDTreeElement*> elementsPtrs = toPtrs(elements);
+        std::cout<<"Performing kNN graph test on "<<numberOfElements<<" elements..."<<std::endl;
+        kdTree->setNewElements(elementsPtrs);
+
+        for(int k: ks){
+            KDTreeKNNGraph graph = kdTree->buildKNNGraph(0);
+            std::vector<std::vector<KDTreeElement*>> naiveResults(graph.elements.size());
+            std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+            for(int i=0;i<graph.elements.size();i++){
+                naiveResults.at(i) = kdTree->getKNearest(graph.elements.at(i),k+1);
+            }
+            std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+            auto naiveMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+            std::cout<<"k = "<<k<<": naive loop "<<naiveMicroseconds/1000.0<<" ms"<<std::endl;
+            for(int threadsNumber: threadsNumbers){
+                ParallelForPool pool(threadsNumber);
+                std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+                graph = kdTree->buildKNNGraph(k,&pool);
+                std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+                auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+                //Naive results include element itself (or other element with the same value) at distance 0
+                int mismatches = 0;
+                for(int i=0;i<graph.elements.size();i++){
+                    auto element = graph.elements.at(i);
+                    for(int j=0;j<k;j++){
+                        auto neighbour = graph.elements.at(graph.neighbours.at(graph.offsets.at(i)+j));
+                        if((*neighbour - *element).length() != (*naiveResults.at(i).at(j+1) - *element).length()){
+                            mismatches++;
+                            break;
+                        }
+                    }
+                }
+                std::cout<<threadsNumber<<" threads: "<<microseconds/1000.0<<" ms, speedup "<<
+                           (double) naiveMicroseconds/std::max<long long>(microseconds,1)<<
+                           (mismatches == 0 ? "" : ", MISMATCHES: " + std::to_string(mismatches))<<std::endl;
+            }
+        }
+    }
+
+protected:
+    static std::vector<KDTreeElement*> toPtrs(std::vector<KDTreeElement> &elements){
+        std::vector<KDTreeElement*> elementsPtrs;
+        for(auto &element: elements){
+            elementsPtrs.push_back(&element);
+        }
+        return elementsPtrs;
+    }
+};
+
+#endif // KD_TREE_BENCHMARK_H
@@ -0,0 +1,205 @@
+#ifndef KD_TREE_DYNAMIC_H
+#define KD_TREE_DYNAMIC_H
+#include <type_traits>
+#include <unordered_map>
+
+#include "kd_tree.h"
+#include "kd_tree_implicit.h"
+#include "kd_tree_searchers.h"
+
+/*
+ * KD tree that supports insert and erase. It is a logarithmic forest: level i is static KDTreeImplicit of at most 2^i elements.
+ * Insert merges new element with all full levels below first one that can hold them and rebuilds that level,
+ * so every element is rebuilt O(log n) times. Building level of m elements runs nth_element on every depth of it,
+ * which is O(m log m), so insert costs O(log^2 n) amortized. Erase only marks element as erased, erased elements
+ * are dropped when their level is merged, and whole forest is rebuilt once erased elements outnumber alive ones.
+ * Queries search every level
+ */
+class KDTreeDynamic: public KDTree{
+public:
+    KDTreeDynamic(int bucketSize = 16):bucketSize(std::max(1,bucketSize)){}
+    KDTreeDynamic(const std::vector<KDTreeElement*> &elements, int bucketSize = 16): KDTreeDynamic(bucketSize){
+        setNewElements(elements);
+    }
+    virtual ~KDTreeDynamic() override{}
+    virtual std::vector<KDTreeElement*> getElementsClosestTo(const KDTreeElement* element, KDTreeSearchTrace *trace = nullptr) const override{
+        std::vector<KDTreeElement*> nearestElements;
+        if(trace != nullptr) trace->clear();
+        KDTreeElement* closestElement = getClosestElement(element,trace);
+        if(closestElement != nullptr){
+            //Elements with the same value as the closest one are exactly at distance 0 from it
+            KDTreeRadiusSearcher<KDTreeElement*> sameValueSearcher(0,nearestElements);
+            searchLevels(*closestElement,sameValueSearcher,nullptr);
+        }
+        return nearestElements;
+    }
+    virtual std::vector<KDTreeElement*> getKNearest(const KDTreeElement* element, int k, KDTreeSearchTrace *trace = nullptr) const override{
+        if(trace != nullptr) trace->clear();
+        if(k<=0) return std::vector<KDTreeElement*>();
+        KDTreeKNearestSearcher<KDTreeElement*> searcher(k);
+        searchLevels(*element,searcher,trace);
+        return searcher.popSorted();
+    }
+    virtual void getWithinRadius(const KDTreeElement* element, double radius, std::vector<KDTreeElement*> &result, KDTreeSearchTrace *trace = nullptr) const override{
+        if(trace != nullptr) trace->clear();
+        if(radius>=0){
+            KDTreeRadiusSearcher<KDTreeElement*> searcher(radius,result);
+            searchLevels(*element,searcher,trace);
+        }
+    }
+    virtual void setNewElements(std::vector<KDTreeElement*> elements) override{
+        clear();
+        //The same element given twice is kept once
+        std::sort(elements.begin(),elements.end());
+        elements.erase(std::unique(elements.begin(),elements.end()),elements.end());
+        rebuild(elements);
+    }
+    virtual void clear() override{
+        levels.clear();
+        locations.clear();
+        erasedNumber = 0;
+    }
+    //Returns false if element is already in tree
+    bool insert(KDTreeElement *element){
+        if(locations.count(element) != 0) return false;
+        std::vector<KDTreeElement*> elements = {element};
+        for(int levelId=0;;levelId++){
+            if(levelId == levels.size()) levels.emplace_back(bucketSize);
+            Level &level = levels.at(levelId);
+            if(level.getElementsNumber() == 0 && elements.size() <= getLevelCapacity(levelId)){
+                buildLevel(levelId,elements);
+                return true;
+            }
+            level.appendAliveElements(elements);
+            erasedNumber -= level.getErasedNumber();
+            level.clear();
+        }
+    }
+    //Returns false if element is not in tree
+    bool erase(KDTreeElement *element){
+        auto locationIt = locations.find(element);
+        if(locationIt == locations.end()) return false;
+        levels.at(locationIt->second.first).markErased(locationIt->second.second);
+        locations.erase(locationIt);
+        erasedNumber++;
+        if(erasedNumber > locations.size()){
+            std::vector<KDTreeElement*> elements;
+            for(auto &level: levels){
+                level.appendAliveElements(elements);
+            }
+            clear();
+            rebuild(elements);
+        }
+        return true;
+    }
+    int size() const{
+        return locations.size();
+    }
+    int getLevelsNumber() const{
+        return levels.size();
+    }
+
+protected:
+    virtual KDTreeElement* getClosestElement(const KDTreeElement* element) const override{
+        return getClosestElement(element,nullptr);
+    }
+    KDTreeElement* getClosestElement(const KDTreeElement* element, KDTreeSearchTrace *trace) const{
+        KDTreeClosestSearcher<KDTreeElement*> searcher(nullptr);
+        searchLevels(*element,searcher,trace);
+        return searcher.closestItem;
+    }
+    static size_t getLevelCapacity(int levelId){
+        return size_t(1) << levelId;
+    }
+    //Puts all elements into the smallest level that can hold them
+    void rebuild(const std::vector<KDTreeElement*> &elements){
+        if(elements.empty()) return;
+        int levelId = 0;
+        while(getLevelCapacity(levelId) < elements.size()) levelId++;
+        while(levels.size() <= levelId) levels.emplace_back(bucketSize);
+        buildLevel(levelId,elements);
+    }
+    void buildLevel(int levelId, const std::vector<KDTreeElement*> &elements){
+        Level &level = levels.at(levelId);
+        level.setNewElements(elements);
+        for(int i=0;i<level.getElementsNumber();i++){
+            locations[level.getElement(i)] = std::make_pair(levelId,i);
+        }
+    }
+
+    //Static level of forest, elements are addressed by their ids in KDTreeImplicit
+    class Level: public KDTreeImplicit{
+    public:
+        Level(int bucketSize):KDTreeImplicit(bucketSize){}
+        virtual void setNewElements(std::vector<KDTreeElement*> elements) override{
+            KDTreeImplicit::setNewElements(elements);
+            isErased.assign(elementsPtrs.size(),false);
+            erasedNumber = 0;
+        }
+        virtual void clear() override{
+            KDTreeImplicit::clear();
+            isErased.clear();
+            erasedNumber = 0;
+        }
+        void markErased(int elementId){
+            isErased.at(elementId) = true;
+            erasedNumber++;
+        }
+        void appendAliveElements(std::vector<KDTreeElement*> &elements) const{
+            for(int i=0;i<elementsPtrs.size();i++){
+                if(!isErased[i]) elements.push_back(elementsPtrs[i]);
+            }
+        }
+        //Searcher gets visit(element, squaredDistance) only for alive elements
+        template <class SEARCHER>
+        void searchAlive(const KDTreeElement &element, SEARCHER &searcher, KDTreeSearchTrace *trace) const{
+            if(elementsPtrs.size() == erasedNumber) return;
+            AliveSearcher<SEARCHER> aliveSearcher{searcher,*this};
+            searchIds(element,aliveSearcher,trace);
+        }
+        KDTreeElement* getElement(int elementId) const{
+            return elementsPtrs.at(elementId);
+        }
+        int getElementsNumber() const{
+            return elementsPtrs.size();
+        }
+        int getErasedNumber() const{
+            return erasedNumber;
+        }
+    protected:
+        template <class SEARCHER>
+        struct AliveSearcher{
+            bool isWorthVisiting(double minPossibleSquaredDistance) const{
+                return searcher.isWorthVisiting(minPossibleSquaredDistance);
+            }
+            //See KDTreeImplicit::searchElements
+            void visit(int elementId, double squaredDistance){
+                if(searcher.isWorthVisiting(squaredDistance) && !level.isErased[elementId]){
+                    searcher.visit(level.elementsPtrs[elementId],squaredDistance);
+                }
+            }
+            SEARCHER &searcher;
+            const Level &level;
+        };
+        std::vector<bool> isErased;
+        int erasedNumber = 0;
+    };
+    static_assert(std::is_nothrow_move_constructible<Level>::value, "Levels must be moved, not copied, when levels grow");
+
+    //Bigger levels are searched first, so small ones are mostly pruned by what was found there
+    template <class SEARCHER>
+    void searchLevels(const KDTreeElement &element, SEARCHER &searcher, KDTreeSearchTrace *trace) const{
+        for(int levelId=levels.size()-1;levelId>=0;levelId--){
+            levels.at(levelId).searchAlive(element,searcher,trace);
+        }
+    }
+
+protected:
+    int bucketSize;
+    std::vector<Level> levels;
+    //Level and position in it of every alive element
+    std::unordered_map<KDTreeElement*,std::pair<int,int>> locations;
+    int erasedNumber = 0;
+};
+
+#endif // KD_TREE_DYNAMIC_H
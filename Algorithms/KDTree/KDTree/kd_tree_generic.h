@@ -0,0 +1,488 @@
+#ifndef KD_TREE_GENERIC_H
+#define KD_TREE_GENERIC_H
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <queue>
+#include <limits>
+#include <cstdint>
+#include <type_traits>
+
+#include "kd_tree_searchers.h"
+#include "../../QuadTree/QuadTree/quad_tree_parallel.h"
+
+//Squared distance between points, unrolled at compile time. Axes are summed in order, as leaf scans of KDTreeGeneric do
+template <class Scalar, int Dim, int AXIS = 0>
+struct KDTreeGenericSquaredDistance{
+    static Scalar compute(const std::array<Scalar,Dim> &a, const std::array<Scalar,Dim> &b, Scalar sum = 0){
+        Scalar difference = a[AXIS] - b[AXIS];
+        return KDTreeGenericSquaredDistance<Scalar,Dim,AXIS+1>::compute(a,b,sum + difference*difference);
+    }
+};
+template <class Scalar, int Dim>
+struct KDTreeGenericSquaredDistance<Scalar,Dim,Dim>{
+    static Scalar compute(const std::array<Scalar,Dim> &, const std::array<Scalar,Dim> &, Scalar sum = 0){
+        return sum;
+    }
+};
+
+/*
+ * k nearest neighbours graph of KDTreeGeneric in compressed sparse row form: neighbours of point with id i are
+ * ids neighbours.at(j) for j in [offsets.at(i),offsets.at(i+1)), sorted by distance
+ */
+struct KDTreeGenericKNNGraph{
+    std::vector<int> offsets;
+    std::vector<int> neighbours;
+};
+
+/*
+ * KD tree over Dim-dimensional points of type Scalar without Qt dependency. Coordinates are copied in tree order
+ * into one array per axis together with ids of points (indexes in vector given to setNewPoints), queries return those ids.
+ * Layout is implicit: range [begin,end) keeps median at its middle and children are [begin,middle) and [middle+1,end).
+ * Splitting axis of every range is the one along which its points have the biggest spread, it is stored at middle.
+ * Ranges of at most bucketSize points are leaves scanned linearly
+ */
+template <class Scalar, int Dim>
+class KDTreeGeneric{
+    static_assert(std::is_floating_point<Scalar>::value, "Coordinates must be floating point");
+    static_assert(Dim > 0, "Tree must have at least one dimension");
+
+public:
+    typedef std::array<Scalar,Dim> POINT;
+    struct BOX{
+        POINT min, max;
+    };
+
+    KDTreeGeneric(int bucketSize = 16):bucketSize(std::max(1,bucketSize)){}
+    KDTreeGeneric(const std::vector<POINT> &points, int bucketSize = 16): KDTreeGeneric(bucketSize){
+        setNewPoints(points);
+    }
+    void setNewPoints(const std::vector<POINT> &newPoints){
+        clear();
+        ids.resize(newPoints.size());
+        for(int i=0;i<ids.size();i++){
+            ids[i] = i;
+        }
+        //Tree is built over coordinates in input order, then they are permuted into tree order
+        for(int axis=0;axis<Dim;axis++){
+            coordinates[axis].resize(newPoints.size());
+            for(int i=0;i<newPoints.size();i++){
+                coordinates[axis][i] = newPoints[i][axis];
+            }
+        }
+        splitAxes.resize(newPoints.size());
+        buildTree(0,ids.size());
+        std::vector<Scalar> buffer(ids.size());
+        for(int axis=0;axis<Dim;axis++){
+            for(int i=0;i<ids.size();i++){
+                buffer[i] = coordinates[axis][ids[i]];
+            }
+            coordinates[axis].swap(buffer);
+        }
+    }
+    void clear(){
+        for(auto &axisCoordinates: coordinates){
+            axisCoordinates.clear();
+        }
+        ids.clear();
+        splitAxes.clear();
+    }
+    int size() const{
+        return ids.size();
+    }
+    int getBucketSize() const{
+        return bucketSize;
+    }
+    //Id of one of the closest points or -1 if tree is empty
+    int getClosest(const POINT &point) const{
+        KDTreeClosestSearcher<int,Scalar> searcher(-1);
+        search(point,searcher);
+        return searcher.closestItem;
+    }
+    //Ids of k closest points sorted by distance
+    std::vector<int> getKNearest(const POINT &point, int k) const{
+        if(k<=0) return std::vector<int>();
+        KDTreeKNearestSearcher<int,Scalar> searcher(k);
+        search(point,searcher);
+        return searcher.popSorted();
+    }
+    //Appends ids of all points not further than radius from given one to result
+    void getWithinRadius(const POINT &point, Scalar radius, std::vector<int> &result) const{
+        if(radius<0) return;
+        KDTreeRadiusSearcher<int,Scalar> searcher(radius,result);
+        search(point,searcher);
+    }
+    /*
+     * Searcher (see kd_tree_searchers.h) gets visit(id, squaredDistance) for points of visited ranges.
+     * If visitedBoxes is given, bounding box of every visited range is appended to it
+     */
+    template <class SEARCHER>
+    void search(const POINT &point, SEARCHER &searcher, std::vector<BOX> *visitedBoxes = nullptr) const{
+        if(ids.empty()) return;
+        POINT offsets;
+        offsets.fill(0);
+        BOX box = getBiggestBox();
+        search(0,ids.size(),point,offsets,0,searcher,box,visitedBoxes);
+    }
+    /*
+     * k nearest neighbours of every point except itself (points with the same value are neighbours at distance 0).
+     * Dual tree traversal: tree is descended as query tree and as reference tree at once, pair of ranges is pruned
+     * if distance between their bounding boxes is not smaller than bound of query range, which is the biggest k-th distance
+     * found so far for its points. If pool is given, top query ranges are split into contiguous chunks of tree order,
+     * one for each of its threads
+     */
+    KDTreeGenericKNNGraph buildKNNGraph(int k, ParallelForPool *pool = nullptr) const{
+        KDTreeGenericKNNGraph graph;
+        int size = ids.size();
+        int neighboursNumber = std::max(0,std::min(k,size-1));
+        graph.offsets.resize(size+1);
+        for(int i=0;i<=size;i++){
+            graph.offsets[i] = i*neighboursNumber;
+        }
+        graph.neighbours.resize(size*neighboursNumber);
+        if(neighboursNumber == 0) return graph;
+        int threadsNumber = pool != nullptr ? std::max(1,std::min(pool->getThreadsNumber(),size)) : 1;
+        //Few ranges per thread, so that chunks of similar number of points can be made of them
+        int depth = 0;
+        while(threadsNumber > 1 && (1 << depth) < threadsNumber*4) depth++;
+        std::vector<std::pair<int,int>> queryRanges;
+        collectQueryRanges(0,size,depth,queryRanges);
+        KNNTraversal traversal(*this,neighboursNumber);
+        auto processChunk = [&](int chunkBegin, int chunkEnd){
+            for(int i=chunkBegin;i<chunkEnd;i++){
+                traversal.search(queryRanges[i].first,queryRanges[i].second,0,size);
+                traversal.writeNeighbours(queryRanges[i].first,queryRanges[i].second,graph.neighbours);
+            }
+        };
+        //Thread t takes ranges starting before size*(t+1)/threadsNumber which are not taken by previous threads
+        std::vector<int> chunkEnds(threadsNumber);
+        int rangeIndex = 0;
+        for(int thread=0;thread<threadsNumber;thread++){
+            while(rangeIndex < queryRanges.size() && queryRanges[rangeIndex].first < (long long)size*(thread+1)/threadsNumber) rangeIndex++;
+            chunkEnds[thread] = rangeIndex;
+        }
+        auto processThreadChunks = [&](int firstThread, int lastThread){
+            for(int thread=firstThread;thread<lastThread;thread++){
+                processChunk(thread == 0 ? 0 : chunkEnds[thread-1],chunkEnds[thread]);
+            }
+        };
+        if(pool != nullptr){
+            pool->parallelFor(0,threadsNumber,processThreadChunks);
+        }else{
+            processThreadChunks(0,threadsNumber);
+        }
+        return graph;
+    }
+    static Scalar squaredDistance(const POINT &a, const POINT &b){
+        return KDTreeGenericSquaredDistance<Scalar,Dim>::compute(a,b);
+    }
+
+protected:
+    /*
+     * Ids in [begin,end) are reordered so that range's median along axis of the biggest spread is at middle.
+     * Coordinates are still in input order, so they are indexed by ids
+     */
+    void buildTree(int begin, int end){
+        if(end - begin <= bucketSize) return;
+        int splitAxis = 0;
+        Scalar biggestSpread = -1;
+        for(int axis=0;axis<Dim;axis++){
+            const std::vector<Scalar> &axisCoordinates = coordinates[axis];
+            Scalar minValue = axisCoordinates[ids[begin]], maxValue = minValue;
+            for(int i=begin+1;i<end;i++){
+                minValue = std::min(minValue,axisCoordinates[ids[i]]);
+                maxValue = std::max(maxValue,axisCoordinates[ids[i]]);
+            }
+            if(maxValue - minValue > biggestSpread){
+                biggestSpread = maxValue - minValue;
+                splitAxis = axis;
+            }
+        }
+        int middle = begin + (end - begin)/2;
+        const std::vector<Scalar> &axisCoordinates = coordinates[splitAxis];
+        std::nth_element(ids.begin()+begin,ids.begin()+middle,ids.begin()+end,[&axisCoordinates](int a, int b){
+            return axisCoordinates[a] < axisCoordinates[b];
+        });
+        splitAxes[middle] = splitAxis;
+        buildTree(begin,middle);
+        buildTree(middle+1,end);
+    }
+    Scalar getSquaredDistance(int position, const POINT &point) const{
+        Scalar squaredDistance = 0;
+        for(int axis=0;axis<Dim;axis++){
+            Scalar difference = coordinates[axis][position] - point[axis];
+            squaredDistance += difference*difference;
+        }
+        return squaredDistance;
+    }
+    POINT getPoint(int position) const{
+        POINT point;
+        for(int axis=0;axis<Dim;axis++){
+            point[axis] = coordinates[axis][position];
+        }
+        return point;
+    }
+    static BOX getBiggestBox(){
+        BOX box;
+        box.min.fill(std::numeric_limits<Scalar>::lowest());
+        box.max.fill(std::numeric_limits<Scalar>::max());
+        return box;
+    }
+
+    /*
+     * Squared distances from point to positions [begin,end), at most MAX_LEAF_SCAN of them. Every axis is one loop over
+     * contiguous coordinates, so it can be vectorized
+     */
+    void getSquaredDistances(int begin, int end, const POINT &point, Scalar *squaredDistances) const{
+        const Scalar *firstCoordinates = coordinates[0].data();
+        for(int i=begin;i<end;i++){
+            Scalar difference = firstCoordinates[i] - point[0];
+            squaredDistances[i-begin] = difference*difference;
+        }
+        for(int axis=1;axis<Dim;axis++){
+            const Scalar *axisCoordinates = coordinates[axis].data();
+            Scalar value = point[axis];
+            for(int i=begin;i<end;i++){
+                Scalar difference = axisCoordinates[i] - value;
+                squaredDistances[i-begin] += difference*difference;
+            }
+        }
+    }
+    //Squared distances of leaf are computed first in separate loops, then searcher visits points
+    template <class SEARCHER>
+    void scanLeaf(int begin, int end, const POINT &point, SEARCHER &searcher) const{
+        Scalar squaredDistances[MAX_LEAF_SCAN];
+        for(int chunkBegin=begin;chunkBegin<end;chunkBegin+=MAX_LEAF_SCAN){
+            int chunkEnd = std::min(chunkBegin+MAX_LEAF_SCAN,end);
+            getSquaredDistances(chunkBegin,chunkEnd,point,squaredDistances);
+            for(int i=chunkBegin;i<chunkEnd;i++){
+                searcher.visit(ids[i],squaredDistances[i-chunkBegin]);
+            }
+        }
+    }
+    /*
+     * offsets hold distance from point to range's bounding box along every axis and squaredBoxDistance is sum of their squares,
+     * far child differs from its parent only in offset along splitting axis (see KDTreeFirstImpl::searchNodes).
+     * box is narrowed in place to child's one while child is searched, only when visitedBoxes is given
+     */
+    template <class SEARCHER>
+    void search(int begin, int end, const POINT &point, POINT &offsets, Scalar squaredBoxDistance, SEARCHER &searcher,
+                BOX &box, std::vector<BOX> *visitedBoxes) const{
+        if(visitedBoxes != nullptr) visitedBoxes->push_back(box);
+        if(end - begin <= bucketSize){
+            scanLeaf(begin,end,point,searcher);
+            return;
+        }
+        int middle = begin + (end - begin)/2;
+        searcher.visit(ids[middle],getSquaredDistance(middle,point));
+        int axis = splitAxes[middle];
+        Scalar splitValue = coordinates[axis][middle];
+        Scalar difference = point[axis] - splitValue;
+        bool isNearLower = difference < 0;
+        int nearBegin = isNearLower ? begin : middle+1;
+        int nearEnd = isNearLower ? middle : end;
+        int farBegin = isNearLower ? middle+1 : begin;
+        int farEnd = isNearLower ? end : middle;
+        Scalar &nearBound = isNearLower ? box.max[axis] : box.min[axis];
+        Scalar &farBound = isNearLower ? box.min[axis] : box.max[axis];
+        Scalar prevBound = nearBound;
+        if(visitedBoxes != nullptr) nearBound = splitValue;
+        search(nearBegin,nearEnd,point,offsets,squaredBoxDistance,searcher,box,visitedBoxes);
+        if(visitedBoxes != nullptr) nearBound = prevBound;
+        Scalar prevOffset = offsets[axis];
+        Scalar farSquaredBoxDistance = squaredBoxDistance - prevOffset*prevOffset + difference*difference;
+        if(searcher.isWorthVisiting(farSquaredBoxDistance)){
+            offsets[axis] = difference;
+            prevBound = farBound;
+            if(visitedBoxes != nullptr) farBound = splitValue;
+            search(farBegin,farEnd,point,offsets,farSquaredBoxDistance,searcher,box,visitedBoxes);
+            if(visitedBoxes != nullptr) farBound = prevBound;
+            offsets[axis] = prevOffset;
+        }
+    }
+
+    //Query ranges of buildKNNGraph: tree is split for depth levels and medians above that depth are single point ranges
+    void collectQueryRanges(int begin, int end, int depth, std::vector<std::pair<int,int>> &ranges) const{
+        if(begin == end) return;
+        if(depth == 0 || end - begin <= bucketSize){
+            ranges.push_back(std::make_pair(begin,end));
+            return;
+        }
+        int middle = begin + (end - begin)/2;
+        collectQueryRanges(begin,middle,depth-1,ranges);
+        ranges.push_back(std::make_pair(middle,middle+1));
+        collectQueryRanges(middle+1,end,depth-1,ranges);
+    }
+    /*
+     * State of buildKNNGraph: max-heap of nearest neighbours of every position, bounding boxes of ranges and bounds
+     * of query ranges. Range of at most bucketSize points is leaf, so is median alone, otherwise range is made of
+     * median [middle,middle+1) and children [begin,middle) and [middle+1,end). Box and bound of leaf are kept at its begin
+     * and those of other range at its middle, two leaves or two other ranges never share that position.
+     * Query ranges given to search must not overlap between threads
+     */
+    struct KNNTraversal{
+        typedef std::pair<Scalar,int> DISTANCE_POSITION;
+        KNNTraversal(const KDTreeGeneric &tree, int k):
+            tree(tree),k(k),heaps(tree.size()*k),heapSizes(tree.size(),0),leafBoxes(tree.size()),innerBoxes(tree.size()),
+            leafBounds(tree.size(),std::numeric_limits<Scalar>::max()),innerBounds(tree.size(),std::numeric_limits<Scalar>::max()){
+            computeBox(0,tree.size());
+        }
+        //Nearest neighbours of query range [queryBegin,queryEnd) among points of reference range [referenceBegin,referenceEnd)
+        void search(int queryBegin, int queryEnd, int referenceBegin, int referenceEnd){
+            if(queryBegin == queryEnd || referenceBegin == referenceEnd) return;
+            search(queryBegin,queryEnd,referenceBegin,referenceEnd,getSquaredDistance(queryBegin,queryEnd,referenceBegin,referenceEnd));
+        }
+        //Heaps hold positions in tree order, graph gets ids
+        void writeNeighbours(int begin, int end, std::vector<int> &neighbours){
+            for(int i=begin;i<end;i++){
+                std::sort_heap(heaps.begin()+i*k,heaps.begin()+(i+1)*k);
+                for(int j=0;j<k;j++){
+                    neighbours[tree.ids[i]*k+j] = tree.ids[heaps[i*k+j].second];
+                }
+            }
+        }
+
+    protected:
+        bool isLeaf(int begin, int end) const{
+            return end - begin <= tree.bucketSize;
+        }
+        static int getMiddle(int begin, int end){
+            return begin + (end - begin)/2;
+        }
+        //Range must not be empty
+        const BOX &getBox(int begin, int end) const{
+            return isLeaf(begin,end) ? leafBoxes[begin] : innerBoxes[getMiddle(begin,end)];
+        }
+        Scalar getBound(int begin, int end) const{
+            return isLeaf(begin,end) ? leafBounds[begin] : innerBounds[getMiddle(begin,end)];
+        }
+        Scalar getBound(int position) const{
+            return heapSizes[position] < k ? std::numeric_limits<Scalar>::max() : heaps[position*k].first;
+        }
+        //Same for non empty ranges whose bounding boxes are squaredBoxDistance apart, parent computes it to order children
+        void search(int queryBegin, int queryEnd, int referenceBegin, int referenceEnd, Scalar squaredBoxDistance){
+            if(squaredBoxDistance >= getBound(queryBegin,queryEnd)) return;
+            bool isQueryLeaf = isLeaf(queryBegin,queryEnd), isReferenceLeaf = isLeaf(referenceBegin,referenceEnd);
+            if(isQueryLeaf && isReferenceLeaf){
+                scan(queryBegin,queryEnd,referenceBegin,referenceEnd);
+            }else if(isQueryLeaf || (!isReferenceLeaf && referenceEnd - referenceBegin > queryEnd - queryBegin)){
+                //Bigger range is split, reference children closer to query range go first
+                int middle = getMiddle(referenceBegin,referenceEnd);
+                if(isQueryLeaf){
+                    scan(queryBegin,queryEnd,middle,middle+1);
+                }else{
+                    search(queryBegin,queryEnd,middle,middle+1,getSquaredDistance(queryBegin,queryEnd,middle,middle+1));
+                }
+                Scalar lowerDistance = getSquaredDistance(queryBegin,queryEnd,referenceBegin,middle);
+                if(middle+1 == referenceEnd){
+                    search(queryBegin,queryEnd,referenceBegin,middle,lowerDistance);
+                    return;
+                }
+                Scalar upperDistance = getSquaredDistance(queryBegin,queryEnd,middle+1,referenceEnd);
+                if(lowerDistance <= upperDistance){
+                    search(queryBegin,queryEnd,referenceBegin,middle,lowerDistance);
+                    search(queryBegin,queryEnd,middle+1,referenceEnd,upperDistance);
+                }else{
+                    search(queryBegin,queryEnd,middle+1,referenceEnd,upperDistance);
+                    search(queryBegin,queryEnd,referenceBegin,middle,lowerDistance);
+                }
+            }else{
+                int middle = getMiddle(queryBegin,queryEnd);
+                search(middle,middle+1,referenceBegin,referenceEnd);
+                search(queryBegin,middle,referenceBegin,referenceEnd);
+                search(middle+1,queryEnd,referenceBegin,referenceEnd);
+                //Bound of range is the biggest of its children's ones
+                Scalar bound = std::max(leafBounds[middle],getBound(queryBegin,middle));
+                if(middle+1 < queryEnd) bound = std::max(bound,getBound(middle+1,queryEnd));
+                innerBounds[middle] = bound;
+            }
+        }
+        Scalar getSquaredDistance(int queryBegin, int queryEnd, int referenceBegin, int referenceEnd) const{
+            const BOX &queryBox = getBox(queryBegin,queryEnd);
+            return getSquaredDistance(queryBox.min,queryBox.max,getBox(referenceBegin,referenceEnd));
+        }
+        static Scalar getSquaredDistance(const POINT &min, const POINT &max, const BOX &box){
+            Scalar squaredDistance = 0;
+            for(int axis=0;axis<Dim;axis++){
+                Scalar difference = std::max<Scalar>(0,std::max(box.min[axis] - max[axis],min[axis] - box.max[axis]));
+                squaredDistance += difference*difference;
+            }
+            return squaredDistance;
+        }
+        //Bounding boxes of range and all ranges inside it
+        void computeBox(int begin, int end){
+            if(begin == end) return;
+            if(isLeaf(begin,end)){
+                BOX &box = leafBoxes[begin];
+                for(int axis=0;axis<Dim;axis++){
+                    const std::vector<Scalar> &axisCoordinates = tree.coordinates[axis];
+                    box.min[axis] = *std::min_element(axisCoordinates.begin()+begin,axisCoordinates.begin()+end);
+                    box.max[axis] = *std::max_element(axisCoordinates.begin()+begin,axisCoordinates.begin()+end);
+                }
+                return;
+            }
+            int middle = getMiddle(begin,end);
+            computeBox(middle,middle+1);
+            computeBox(begin,middle);
+            computeBox(middle+1,end);
+            BOX &box = innerBoxes[middle];
+            box = leafBoxes[middle];
+            const BOX &lowerBox = getBox(begin,middle);
+            extend(box,lowerBox.min,lowerBox.max);
+            if(middle+1 < end){
+                const BOX &upperBox = getBox(middle+1,end);
+                extend(box,upperBox.min,upperBox.max);
+            }
+        }
+        static void extend(BOX &box, const POINT &min, const POINT &max){
+            for(int axis=0;axis<Dim;axis++){
+                box.min[axis] = std::min(box.min[axis],min[axis]);
+                box.max[axis] = std::max(box.max[axis],max[axis]);
+            }
+        }
+        //Both ranges are leaves, query points whose bound is below distance to reference box take all its points
+        void scan(int queryBegin, int queryEnd, int referenceBegin, int referenceEnd){
+            const BOX &referenceBox = getBox(referenceBegin,referenceEnd);
+            Scalar bound = 0;
+            for(int position=queryBegin;position<queryEnd;position++){
+                POINT point = tree.getPoint(position);
+                if(getSquaredDistance(point,point,referenceBox) < getBound(position)){
+                    for(int i=referenceBegin;i<referenceEnd;i++){
+                        if(i != position) push(position,i,tree.getSquaredDistance(i,point));
+                    }
+                }
+                bound = std::max(bound,getBound(position));
+            }
+            leafBounds[queryBegin] = bound;
+        }
+        void push(int position, int neighbourPosition, Scalar squaredDistance){
+            auto heapBegin = heaps.begin() + position*k;
+            int &heapSize = heapSizes[position];
+            if(heapSize < k){
+                heapBegin[heapSize++] = DISTANCE_POSITION(squaredDistance,neighbourPosition);
+                std::push_heap(heapBegin,heapBegin+heapSize);
+            }else if(squaredDistance < heapBegin->first){
+                std::pop_heap(heapBegin,heapBegin+k);
+                heapBegin[k-1] = DISTANCE_POSITION(squaredDistance,neighbourPosition);
+                std::push_heap(heapBegin,heapBegin+k);
+            }
+        }
+
+        const KDTreeGeneric &tree;
+        int k;
+        std::vector<DISTANCE_POSITION> heaps;
+        std::vector<int> heapSizes;
+        std::vector<BOX> leafBoxes, innerBoxes;
+        std::vector<Scalar> leafBounds, innerBounds;
+    };
+
+protected:
+    static const int MAX_LEAF_SCAN = 32;
+    int bucketSize;
+    //Coordinates of points in tree order indexed [axis][position], their ids and splitting axes of ranges whose middle is at given position
+    std::array<std::vector<Scalar>,Dim> coordinates;
+    std::vector<int> ids;
+    std::vector<uint8_t> splitAxes;
+};
+
+#endif // KD_TREE_GENERIC_H
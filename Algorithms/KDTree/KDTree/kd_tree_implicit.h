@@ -0,0 +1,141 @@
+#ifndef KD_TREE_IMPLICIT_H
+#define KD_TREE_IMPLICIT_H
+#include "kd_tree.h"
+#include "kd_tree_generic.h"
+#include "kd_tree_searchers.h"
+
+/*
+ * k nearest neighbours graph in compressed sparse row form: neighbours of elements.at(i) are
+ * elements.at(neighbours.at(j)) for j in [offsets.at(i),offsets.at(i+1)), sorted by distance
+ */
+struct KDTreeKNNGraph{
+    std::vector<KDTreeElement*> elements;
+    std::vector<int> offsets;
+    std::vector<int> neighbours;
+};
+
+/*
+ * KDTree interface over KDTreeGeneric<float,2>: coordinates of elements are copied into generic tree and its ids,
+ * which are positions of elements in vector given to setNewElements, are mapped back to elements.
+ * Elements with the same value are kept as they are
+ */
+class KDTreeImplicit: public KDTree{
+public:
+    typedef KDTreeGeneric<float,2> TREE;
+
+    KDTreeImplicit(int bucketSize = 16):tree(bucketSize){}
+    KDTreeImplicit(const std::vector<KDTreeElement*> &elements, int bucketSize = 16): KDTreeImplicit(bucketSize){
+        setNewElements(elements);
+    }
+    virtual ~KDTreeImplicit() override{}
+    //Destructor is declared, so moves have to be asked for explicitly
+    KDTreeImplicit(const KDTreeImplicit&) = default;
+    KDTreeImplicit(KDTreeImplicit&&) = default;
+    KDTreeImplicit &operator=(const KDTreeImplicit&) = default;
+    KDTreeImplicit &operator=(KDTreeImplicit&&) = default;
+    virtual std::vector<KDTreeElement*> getElementsClosestTo(const KDTreeElement* element, KDTreeSearchTrace *trace = nullptr) const override{
+        std::vector<KDTreeElement*> nearestElements;
+        if(trace != nullptr) trace->clear();
+        KDTreeElement* closestElement = getClosestElement(element,trace);
+        if(closestElement != nullptr){
+            //Elements with the same value as the closest one are exactly at distance 0 from it
+            KDTreeRadiusSearcher<KDTreeElement*> sameValueSearcher(0,nearestElements);
+            searchElements(*closestElement,sameValueSearcher,nullptr);
+        }
+        return nearestElements;
+    }
+    virtual std::vector<KDTreeElement*> getKNearest(const KDTreeElement* element, int k, KDTreeSearchTrace *trace = nullptr) const override{
+        if(trace != nullptr) trace->clear();
+        if(k<=0) return std::vector<KDTreeElement*>();
+        KDTreeKNearestSearcher<KDTreeElement*> searcher(k);
+        searchElements(*element,searcher,trace);
+        return searcher.popSorted();
+    }
+    virtual void getWithinRadius(const KDTreeElement* element, double radius, std::vector<KDTreeElement*> &result, KDTreeSearchTrace *trace = nullptr) const override{
+        if(trace != nullptr) trace->clear();
+        if(radius>=0){
+            KDTreeRadiusSearcher<KDTreeElement*> searcher(radius,result);
+            searchElements(*element,searcher,trace);
+        }
+    }
+    virtual void setNewElements(std::vector<KDTreeElement*> elements) override{
+        clear();
+        elementsPtrs = std::move(elements);
+        std::vector<TREE::POINT> points(elementsPtrs.size());
+        for(int i=0;i<elementsPtrs.size();i++){
+            points[i] = toPoint(*elementsPtrs[i]);
+        }
+        tree.setNewPoints(points);
+    }
+    virtual void clear() override{
+        elementsPtrs.clear();
+        tree.clear();
+    }
+    int getBucketSize() const{
+        return tree.getBucketSize();
+    }
+    //See KDTreeGeneric::buildKNNGraph, elements are in order given to setNewElements
+    KDTreeKNNGraph buildKNNGraph(int k, ParallelForPool *pool = nullptr) const{
+        KDTreeKNNGraph graph;
+        graph.elements = elementsPtrs;
+        KDTreeGenericKNNGraph idsGraph = tree.buildKNNGraph(k,pool);
+        graph.offsets = std::move(idsGraph.offsets);
+        graph.neighbours = std::move(idsGraph.neighbours);
+        return graph;
+    }
+
+protected:
+    virtual KDTreeElement* getClosestElement(const KDTreeElement* element) const override{
+        return getClosestElement(element,nullptr);
+    }
+    KDTreeElement* getClosestElement(const KDTreeElement* element, KDTreeSearchTrace *trace) const{
+        KDTreeClosestSearcher<KDTreeElement*> searcher(nullptr);
+        searchElements(*element,searcher,trace);
+        return searcher.closestItem;
+    }
+    static TREE::POINT toPoint(const KDTreeElement &element){
+        return TREE::POINT{element.x(),element.y()};
+    }
+    //Searcher gets visit(id, squaredDistance), bounding boxes of visited ranges are appended to trace if it is given
+    template <class SEARCHER>
+    void searchIds(const KDTreeElement &element, SEARCHER &searcher, KDTreeSearchTrace *trace) const{
+        if(trace == nullptr){
+            tree.search(toPoint(element),searcher);
+            return;
+        }
+        std::vector<TREE::BOX> visitedBoxes;
+        tree.search(toPoint(element),searcher,&visitedBoxes);
+        for(auto &box: visitedBoxes){
+            trace->visitedAABBs.push_back(AABB_D(box.min[0],box.min[1],box.max[0],box.max[1]));
+        }
+    }
+    /*
+     * Same, but searcher gets elements instead of ids. Elements are in input order, so id is mapped only if
+     * searcher would take it: every searcher takes distance that isWorthVisiting accepts
+     */
+    template <class SEARCHER>
+    void searchElements(const KDTreeElement &element, SEARCHER &searcher, KDTreeSearchTrace *trace) const{
+        ElementSearcher<SEARCHER> elementSearcher(searcher,elementsPtrs);
+        searchIds(element,elementSearcher,trace);
+    }
+    template <class SEARCHER>
+    struct ElementSearcher{
+        ElementSearcher(SEARCHER &searcher, const std::vector<KDTreeElement*> &elementsPtrs):
+            searcher(searcher),elementsPtrs(elementsPtrs){}
+        bool isWorthVisiting(double minPossibleSquaredDistance) const{
+            return searcher.isWorthVisiting(minPossibleSquaredDistance);
+        }
+        void visit(int id, double squaredDistance){
+            if(searcher.isWorthVisiting(squaredDistance)) searcher.visit(elementsPtrs[id],squaredDistance);
+        }
+        SEARCHER &searcher;
+        const std::vector<KDTreeElement*> &elementsPtrs;
+    };
+
+protected:
+    TREE tree;
+    //Elements in order given to setNewElements, so id of tree is index here
+    std::vector<KDTreeElement*> elementsPtrs;
+};
+
+#endif // KD_TREE_IMPLICIT_H
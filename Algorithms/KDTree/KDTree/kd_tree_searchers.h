@@ -0,0 +1,74 @@
+#ifndef KD_TREE_SEARCHERS_H
+#define KD_TREE_SEARCHERS_H
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+/*
+ * Searchers shared by KD trees. They work on squared distances: isWorthVisiting(minPossibleSquaredDistance) decides
+ * if part of tree may hold anything they look for and visit(item, squaredDistance) is called for every item of visited part.
+ * ITEM is whatever tree reports, e.g. element pointer or point id
+ */
+template <class ITEM, class DISTANCE = double>
+struct KDTreeClosestSearcher{
+    //closestItem stays noItem if nothing is visited
+    KDTreeClosestSearcher(const ITEM &noItem = ITEM()):closestItem(noItem){}
+    bool isWorthVisiting(DISTANCE minPossibleSquaredDistance) const{
+        return minPossibleSquaredDistance < closestSquaredDistance;
+    }
+    void visit(const ITEM &item, DISTANCE squaredDistance){
+        if(squaredDistance < closestSquaredDistance){
+            closestItem = item;
+            closestSquaredDistance = squaredDistance;
+        }
+    }
+    ITEM closestItem;
+    DISTANCE closestSquaredDistance = std::numeric_limits<DISTANCE>::max();
+};
+
+//Keeps k closest items in max-heap, top is the furthest of them
+template <class ITEM, class DISTANCE = double>
+struct KDTreeKNearestSearcher{
+    typedef std::pair<DISTANCE,ITEM> DISTANCE_ITEM;
+    KDTreeKNearestSearcher(int k):k(k){}
+    bool isWorthVisiting(DISTANCE minPossibleSquaredDistance) const{
+        return heap.size() < k || minPossibleSquaredDistance < heap.top().first;
+    }
+    void visit(const ITEM &item, DISTANCE squaredDistance){
+        if(heap.size() < k){
+            heap.push(DISTANCE_ITEM(squaredDistance,item));
+        }else if(squaredDistance < heap.top().first){
+            heap.pop();
+            heap.push(DISTANCE_ITEM(squaredDistance,item));
+        }
+    }
+    //Found items sorted by distance, heap is emptied
+    std::vector<ITEM> popSorted(){
+        std::vector<ITEM> items(heap.size());
+        for(int i=items.size()-1;i>=0;i--){
+            items.at(i) = heap.top().second;
+            heap.pop();
+        }
+        return items;
+    }
+    size_t k;
+    std::priority_queue<DISTANCE_ITEM> heap;
+};
+
+//Appends every item not further than radius to result
+template <class ITEM, class DISTANCE = double>
+struct KDTreeRadiusSearcher{
+    KDTreeRadiusSearcher(DISTANCE radius, std::vector<ITEM> &result):
+        squaredRadius(radius*radius),result(result){}
+    bool isWorthVisiting(DISTANCE minPossibleSquaredDistance) const{
+        return minPossibleSquaredDistance <= squaredRadius;
+    }
+    void visit(const ITEM &item, DISTANCE squaredDistance){
+        if(squaredDistance <= squaredRadius) result.push_back(item);
+    }
+    DISTANCE squaredRadius;
+    std::vector<ITEM> &result;
+};
+
+#endif // KD_TREE_SEARCHERS_H
@@ -1,9 +1,28 @@
 #include <QApplication>
 #include <QWidget>
 
+#include "kd_tree_benchmark.h"
+#include "kd_tree_implicit.h"
+
 using namespace std;
 int main(int argc, char *argv[])
 {
+    bool benchmark = true;
+    if(benchmark){
+        KDTreeFirstImpl kdTree;
+        KDTreeBenchmark().compareKNearestWithBruteForce(&kdTree,100000,1000);
+        KDTreeBenchmark().testWithinRadius(&kdTree,100000,1000);
+        KDTreeBenchmark().testNearestBatchScaling(&kdTree,1000000,1000000);
+        KDTreeBenchmark().testBuildScaling(&kdTree);
+        KDTreeBenchmark().testApproximation(&kdTree,1000000,100000);
+        KDTreeImplicit implicitKdTree;
+        KDTreeBenchmark().compareKNearestWithBruteForce(&implicitKdTree,100000,1000);
+        KDTreeBenchmark().testWithinRadius(&implicitKdTree,100000,1000);
+        KDTreeBenchmark().testNearestBatchScaling(&implicitKdTree,1000000,1000000);
+        KDTreeBenchmark().testKNNGraph(&implicitKdTree,1000000);
+        KDTreeDynamic dynamicKdTree;
+        KDTreeBenchmark().testMixedInsertAndQuery(&dynamicKdTree,100000,1000000);
+    }
 //    QApplication a(argc, argv);
 //    MainWindow w;
 //    w.show();
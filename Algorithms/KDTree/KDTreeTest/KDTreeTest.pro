@@ -7,7 +7,11 @@ CONFIG += thread
 
 HEADERS += \
     kd_tree_test.h \
-    aabb_test.h
+    aabb_test.h \
+    kd_tree_implicit_test.h \
+    kd_tree_generic_test.h \
+    kd_tree_dynamic_test.h \
+    kd_tree_test_utils.h
 
 SOURCES += \
         main.cpp
@@ -0,0 +1,103 @@
+#ifndef KD_TREE_DYNAMIC_TEST_H
+#define KD_TREE_DYNAMIC_TEST_H
+#include <set>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+#include "../KDTree/kd_tree.h"
+#include "../KDTree/kd_tree_dynamic.h"
+#include "kd_tree_test_utils.h"
+
+class KDTreeDynamicRandomElements: public  ::testing::Test {
+    protected:
+    void SetUp() override {
+        //Elements are never reallocated, so pointers stay valid while some of them are in tree
+        elements = makeRandomGridElements(3000,200,-50,17);
+    }
+    //Checks all queries of kdTree against KDTreeFirstImpl built from elements that are expected to be in it
+    void compareWithStaticTree(const std::set<KDTreeElement*> &aliveElements){
+        ASSERT_EQ(kdTree.size(),aliveElements.size());
+        KDTreeFirstImpl referenceKDTree(std::vector<KDTreeElement*>(aliveElements.begin(),aliveElements.end()));
+        for(int i=0;i<20;i++){
+            KDTreeElement referenceElement(rand()%300 - 100,rand()%300 - 100);
+            expectSameQueryResults(kdTree,referenceKDTree,referenceElement,rand()%30);
+        }
+    }
+    KDTreeDynamic kdTree;
+    std::vector<KDTreeElement> elements;
+};
+
+TEST_F(KDTreeDynamicRandomElements,insertAndErase)
+{
+    std::set<KDTreeElement*> aliveElements;
+    for(int i=0;i<1000;i++){
+        EXPECT_TRUE(kdTree.insert(&elements.at(i)));
+        aliveElements.insert(&elements.at(i));
+    }
+    EXPECT_FALSE(kdTree.insert(&elements.at(0)));
+    compareWithStaticTree(aliveElements);
+
+    for(int i=0;i<4000;i++){
+        auto element = &elements.at(rand()%elements.size());
+        if(rand()%2 == 0){
+            EXPECT_EQ(kdTree.insert(element),aliveElements.insert(element).second);
+        }else{
+            EXPECT_EQ(kdTree.erase(element),aliveElements.erase(element) == 1);
+        }
+        if(i%500 == 0) compareWithStaticTree(aliveElements);
+    }
+    compareWithStaticTree(aliveElements);
+
+    for(auto element: aliveElements){
+        EXPECT_TRUE(kdTree.erase(element));
+    }
+    aliveElements.clear();
+    compareWithStaticTree(aliveElements);
+    EXPECT_FALSE(kdTree.erase(&elements.at(0)));
+}
+
+TEST_F(KDTreeDynamicRandomElements,setNewElementsThenInsert)
+{
+    std::vector<KDTreeElement*> elementsPtrs;
+    for(int i=0;i<1500;i++){
+        elementsPtrs.push_back(&elements.at(i));
+    }
+    elementsPtrs.push_back(&elements.at(0));
+    kdTree.setNewElements(elementsPtrs);
+    std::set<KDTreeElement*> aliveElements(elementsPtrs.begin(),elementsPtrs.end());
+    compareWithStaticTree(aliveElements);
+    for(int i=1500;i<elements.size();i++){
+        kdTree.insert(&elements.at(i));
+        aliveElements.insert(&elements.at(i));
+    }
+    compareWithStaticTree(aliveElements);
+    EXPECT_LE(kdTree.getLevelsNumber(),13);
+
+    KDTreeElement referenceElement(10,10);
+    KDTreeSearchTrace trace;
+    kdTree.getElementsClosestTo(&referenceElement,&trace);
+    EXPECT_GT(trace.visitedAABBs.size(),0);
+    std::vector<KDTreeElement> queries = {referenceElement,KDTreeElement(-40,100)};
+    std::vector<KDTreeElement*> results;
+    ParallelForPool pool(2);
+    kdTree.getNearestBatch(queries,results,&pool);
+    for(int i=0;i<queries.size();i++){
+        EXPECT_EQ((*results.at(i) - queries.at(i)).length(),(*kdTree.getElementsClosestTo(&queries.at(i)).front() - queries.at(i)).length());
+    }
+}
+
+TEST(KDTreeDynamicTest, ZeroElements)
+{
+    KDTreeDynamic kdTree;
+    KDTreeElement referenceElement {4.5,9};
+    EXPECT_TRUE(kdTree.getElementsClosestTo(&referenceElement).size()==0);
+    EXPECT_TRUE(kdTree.getKNearest(&referenceElement,3).size()==0);
+    kdTree.insert(&referenceElement);
+    EXPECT_EQ(kdTree.getElementsClosestTo(&referenceElement).size(),1);
+    kdTree.clear();
+    EXPECT_EQ(kdTree.size(),0);
+    EXPECT_TRUE(kdTree.getElementsClosestTo(&referenceElement).size()==0);
+}
+
+#endif // KD_TREE_DYNAMIC_TEST_H
@@ -0,0 +1,137 @@
+#ifndef KD_TREE_GENERIC_TEST_H
+#define KD_TREE_GENERIC_TEST_H
+#include <set>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+#include "../KDTree/kd_tree_generic.h"
+#include "kd_tree_test_utils.h"
+
+template <class TREE>
+class KDTreeGenericRandomPoints: public  ::testing::Test {
+    protected:
+    typedef typename TREE::POINT POINT;
+    void SetUp() override {
+        points = makeRandomGridPoints<POINT>(3000,40,-10,13);
+        for(auto &point: points){
+            //Last axis has much bigger spread, so it is split more often
+            point.back() *= 10;
+        }
+        for(int bucketSize: {1,16}){
+            trees.push_back(TREE(points,bucketSize));
+        }
+    }
+    POINT getRandomPoint(){
+        POINT point;
+        for(auto &coordinate: point){
+            coordinate = (rand()%600 - 100) / 10.0;
+        }
+        return point;
+    }
+    std::vector<double> getSortedDistances(const std::vector<int> &ids, const POINT &referencePoint){
+        std::vector<double> distances;
+        for(int id: ids){
+            distances.push_back(TREE::squaredDistance(points.at(id),referencePoint));
+        }
+        std::sort(distances.begin(),distances.end());
+        return distances;
+    }
+    std::vector<int> getAllIds(){
+        std::vector<int> ids(points.size());
+        for(int i=0;i<ids.size();i++){
+            ids.at(i) = i;
+        }
+        return ids;
+    }
+    std::vector<POINT> points;
+    std::vector<TREE> trees;
+};
+
+typedef ::testing::Types<KDTreeGeneric<float,2>,KDTreeGeneric<double,3>,KDTreeGeneric<float,6>> KDTreeGenericTypes;
+TYPED_TEST_SUITE(KDTreeGenericRandomPoints,KDTreeGenericTypes);
+
+TYPED_TEST(KDTreeGenericRandomPoints,getClosestAndKNearest)
+{
+    auto allIds = this->getAllIds();
+    for(auto &tree: this->trees){
+        EXPECT_EQ(tree.size(),this->points.size());
+        for(int i=0;i<50;i++){
+            auto referencePoint = this->getRandomPoint();
+            auto allDistances = this->getSortedDistances(allIds,referencePoint);
+            EXPECT_EQ(TypeParam::squaredDistance(this->points.at(tree.getClosest(referencePoint)),referencePoint),allDistances.front());
+            for(int k: {1,5,64}){
+                auto nearestIds = tree.getKNearest(referencePoint,k);
+                ASSERT_EQ(nearestIds.size(),k);
+                std::vector<double> distances;
+                for(int id: nearestIds){
+                    distances.push_back(TypeParam::squaredDistance(this->points.at(id),referencePoint));
+                }
+                EXPECT_TRUE(std::is_sorted(distances.begin(),distances.end()));
+                EXPECT_EQ(distances,std::vector<double>(allDistances.begin(),allDistances.begin()+k));
+                EXPECT_EQ(std::set<int>(nearestIds.begin(),nearestIds.end()).size(),k);
+            }
+        }
+    }
+}
+
+TYPED_TEST(KDTreeGenericRandomPoints,getWithinRadius)
+{
+    for(auto &tree: this->trees){
+        for(int i=0;i<50;i++){
+            auto referencePoint = this->getRandomPoint();
+            for(double radius: {0.0,3.0,15.0}){
+                std::vector<int> result;
+                tree.getWithinRadius(referencePoint,radius,result);
+                std::set<int> expectedIds;
+                for(int j=0;j<this->points.size();j++){
+                    if(TypeParam::squaredDistance(this->points.at(j),referencePoint) <= radius*radius) expectedIds.insert(j);
+                }
+                EXPECT_EQ(result.size(),expectedIds.size());
+                EXPECT_EQ(std::set<int>(result.begin(),result.end()),expectedIds);
+            }
+        }
+    }
+}
+
+TYPED_TEST(KDTreeGenericRandomPoints,buildKNNGraph)
+{
+    for(auto &tree: this->trees){
+        for(int k: {1,7}){
+            for(int threadsNumber: {1,3}){
+                ParallelForPool pool(threadsNumber);
+                auto graph = tree.buildKNNGraph(k,&pool);
+                ASSERT_EQ(graph.offsets.size(),this->points.size()+1);
+                ASSERT_EQ(graph.neighbours.size(),this->points.size()*k);
+                for(int id=0;id<this->points.size();id+=11){
+                    std::vector<int> otherIds;
+                    for(int otherId=0;otherId<this->points.size();otherId++){
+                        if(otherId != id) otherIds.push_back(otherId);
+                    }
+                    auto allDistances = this->getSortedDistances(otherIds,this->points.at(id));
+                    std::vector<double> distances;
+                    for(int j=graph.offsets.at(id);j<graph.offsets.at(id+1);j++){
+                        ASSERT_NE(graph.neighbours.at(j),id);
+                        distances.push_back(TypeParam::squaredDistance(this->points.at(graph.neighbours.at(j)),this->points.at(id)));
+                    }
+                    EXPECT_EQ(distances,std::vector<double>(allDistances.begin(),allDistances.begin()+k));
+                }
+            }
+        }
+    }
+}
+
+TEST(KDTreeGeneric,ZeroPoints)
+{
+    KDTreeGeneric<double,3> kdTree;
+    KDTreeGeneric<double,3>::POINT referencePoint = {1,2,3};
+    EXPECT_EQ(kdTree.getClosest(referencePoint),-1);
+    EXPECT_EQ(kdTree.getKNearest(referencePoint,3).size(),0);
+    kdTree.setNewPoints({referencePoint});
+    EXPECT_EQ(kdTree.getClosest(referencePoint),0);
+    kdTree.clear();
+    EXPECT_EQ(kdTree.size(),0);
+    EXPECT_EQ(kdTree.getClosest(referencePoint),-1);
+}
+
+#endif // KD_TREE_GENERIC_TEST_H
@@ -0,0 +1,100 @@
+#ifndef KD_TREE_IMPLICIT_TEST_H
+#define KD_TREE_IMPLICIT_TEST_H
+#include <set>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+#include "../KDTree/kd_tree.h"
+#include "../KDTree/kd_tree_implicit.h"
+#include "kd_tree_test_utils.h"
+
+class KDTreeImplicitRandomElements: public  ::testing::TestWithParam<int> {
+    protected:
+    void SetUp() override {
+        elements = makeRandomGridElements(3000,300,-50,11);
+        elementsPtr = elementsToPtrs(elements);
+        kdTree = KDTreeImplicit(GetParam());
+        kdTree.setNewElements(elementsPtr);
+        referenceKDTree.setNewElements(elementsPtr);
+    }
+    KDTreeImplicit kdTree;
+    KDTreeFirstImpl referenceKDTree;
+    std::vector<KDTreeElement*> elementsPtr;
+    std::vector<KDTreeElement> elements;
+};
+
+TEST_P(KDTreeImplicitRandomElements,matchesFirstImpl)
+{
+    for(int i=0;i<200;i++){
+        KDTreeElement referenceElement(rand()%400 - 100,rand()%400 - 100);
+        ASSERT_GT(kdTree.getElementsClosestTo(&referenceElement).size(),0);
+        expectSameQueryResults(kdTree,referenceKDTree,referenceElement,rand()%30);
+    }
+}
+
+TEST_P(KDTreeImplicitRandomElements,traceAndBatch)
+{
+    KDTreeElement referenceElement(100,100);
+    KDTreeSearchTrace trace;
+    kdTree.getElementsClosestTo(&referenceElement,&trace);
+    EXPECT_GT(trace.visitedAABBs.size(),0);
+
+    std::vector<KDTreeElement> queries;
+    for(int i=0;i<300;i++){
+        queries.push_back(KDTreeElement(rand()%400 - 100,rand()%400 - 100));
+    }
+    std::vector<KDTreeElement*> results;
+    ParallelForPool pool(3);
+    kdTree.getNearestBatch(queries,results,&pool);
+    for(int i=0;i<queries.size();i++){
+        EXPECT_EQ((*results.at(i) - queries.at(i)).length(),(*referenceKDTree.getElementsClosestTo(&queries.at(i)).front() - queries.at(i)).length());
+    }
+}
+
+TEST_P(KDTreeImplicitRandomElements,buildKNNGraph)
+{
+    for(int k: {1,6,40}){
+        for(int threadsNumber: {1,3}){
+            ParallelForPool pool(threadsNumber);
+            auto graph = kdTree.buildKNNGraph(k,&pool);
+            ASSERT_EQ(graph.elements.size(),elementsPtr.size());
+            ASSERT_EQ(graph.offsets.size(),elementsPtr.size()+1);
+            ASSERT_EQ(graph.neighbours.size(),elementsPtr.size()*k);
+            EXPECT_EQ(std::set<KDTreeElement*>(graph.elements.begin(),graph.elements.end()),std::set<KDTreeElement*>(elementsPtr.begin(),elementsPtr.end()));
+            for(int i=0;i<graph.elements.size();i+=7){
+                auto element = graph.elements.at(i);
+                std::vector<KDTreeElement*> otherElements;
+                for(auto otherElement: elementsPtr){
+                    if(otherElement != element) otherElements.push_back(otherElement);
+                }
+                auto allDistances = getSortedDistances(otherElements,*element);
+                std::vector<KDTreeElement*> neighbours;
+                for(int j=graph.offsets.at(i);j<graph.offsets.at(i+1);j++){
+                    ASSERT_NE(graph.neighbours.at(j),i);
+                    neighbours.push_back(graph.elements.at(graph.neighbours.at(j)));
+                }
+                EXPECT_EQ(getDistances(neighbours,*element),std::vector<double>(allDistances.begin(),allDistances.begin()+k));
+            }
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(BucketSizes,KDTreeImplicitRandomElements,::testing::Values(1,8,16,32));
+
+TEST(KDTreeImplicitTest, ZeroElements)
+{
+    KDTreeImplicit kdTree;
+    KDTreeElement referenceElement {4.5,9};
+    EXPECT_TRUE(kdTree.getElementsClosestTo(&referenceElement).size()==0);
+    EXPECT_TRUE(kdTree.getKNearest(&referenceElement,3).size()==0);
+    kdTree.setNewElements({&referenceElement});
+    auto graph = kdTree.buildKNNGraph(3);
+    EXPECT_EQ(graph.offsets,std::vector<int>({0,0}));
+    EXPECT_EQ(graph.neighbours.size(),0);
+    kdTree.clear();
+    EXPECT_EQ(kdTree.buildKNNGraph(3).offsets,std::vector<int>({0}));
+    EXPECT_TRUE(kdTree.getElementsClosestTo(&referenceElement).size()==0);
+}
+
+#endif // KD_TREE_IMPLICIT_TEST_H
@@ -1,24 +1,19 @@
 #ifndef KD_TREE_TEST_H
 #define KD_TREE_TEST_H
 #include <iostream>
+#include <set>
+#include <thread>
 
 #include <gtest/gtest.h>
 #include <gmock/gmock-matchers.h>
 
 #include "../KDTree/kd_tree.h"
+#include "kd_tree_test_utils.h"
 
 using namespace testing;
 using std::cout;
 using std::endl;
 
-std::vector<KDTreeElement*> elementsToPtrs(std::vector<KDTreeElement> &elements){
-    std::vector<KDTreeElement*> elementsPtrs;
-    for(auto &element: elements){
-        elementsPtrs.push_back(&element);
-    }
-    return elementsPtrs;
-}
-
 void printElements(std::vector<KDTreeElement> &elements){
     for(auto element: elements){
         cout<<element.x()<<" "<<element.y()<<endl;
@@ -61,7 +56,7 @@ TEST(KDTreeFirstImpl,sortElements){
     EXPECT_TRUE(compareElements(elementsShuffledPtr,elementsToPtrs(elements)));
 }
 
-TEST(KDTreeFirstImpl,removeAndHashNonUniqueElements){
+TEST(KDTreeFirstImpl,makeSameValueNodes){
     KDTreeFirstImpl kdTree;
     std::vector<KDTreeElement> elements = {
                 KDTreeElement {0.5,1},
@@ -84,26 +79,39 @@ TEST(KDTreeFirstImpl,removeAndHashNonUniqueElements){
                 KDTreeElement {4  ,8},
                 KDTreeElement {444444  ,888888}
             };
-    auto elementsPtrs = elementsToPtrs(elements);
-    kdTree.removeAndHashNonUniqueElements(elementsPtrs);
-    EXPECT_EQ(elementsPtrs.size(),elementsUnique.size());
-    EXPECT_TRUE(compareElements(elementsPtrs,elementsToPtrs(elementsUnique)));
-    EXPECT_EQ(kdTree.sameValueElements.size(),2);
-    for(auto &pair: kdTree.sameValueElements){
-        if(*pair.first == KDTreeElement {2  ,4}){
-            EXPECT_EQ(pair.second.size(),2);
-        }else if(*pair.first == KDTreeElement {4  ,8}){
-            EXPECT_EQ(pair.second.size(),5);
+    kdTree.sortedElements = elementsToPtrs(elements);
+    kdTree.makeSameValueNodes();
+    std::vector<KDTreeElement*> nodesElements;
+    for(auto &node: kdTree.nodes){
+        nodesElements.push_back(node.element);
+    }
+    EXPECT_TRUE(compareElements(nodesElements,elementsToPtrs(elementsUnique)));
+    kdTree.clear();
+    kdTree.makeSameValueNodes();
+    EXPECT_EQ(kdTree.nodes.size(),0);
+
+    //After build every node still points to run of its value in sorted elements
+    auto elementsShuffledPtrs = elementsToPtrs(elements);
+    std::random_shuffle(elementsShuffledPtrs.begin(),elementsShuffledPtrs.end());
+    kdTree.setNewElements(elementsShuffledPtrs);
+    EXPECT_EQ(kdTree.sortedElements.size(),elements.size());
+    EXPECT_EQ(kdTree.nodes.size(),elementsUnique.size());
+    for(auto &node: kdTree.nodes){
+        if(*node.element == KDTreeElement {2  ,4}){
+            EXPECT_EQ(node.sameValueCount,2);
+        }else if(*node.element == KDTreeElement {4  ,8}){
+            EXPECT_EQ(node.sameValueCount,5);
         }else{
-            FAIL();
+            EXPECT_EQ(node.sameValueCount,1);
+        }
+        EXPECT_EQ(kdTree.sortedElements.at(node.sameValueBegin),node.element);
+        for(int i=node.sameValueBegin;i<node.sameValueBegin+node.sameValueCount;i++){
+            EXPECT_EQ(*kdTree.sortedElements.at(i),*node.element);
         }
     }
-    std::vector<KDTreeElement*> elementsPtrsEmpty;
-    kdTree.removeAndHashNonUniqueElements(elementsPtrsEmpty);
-    EXPECT_EQ(elementsPtrsEmpty.size(),0);
 }
 
-TEST(KDTreeFirstImpl,buildTree){
+TEST(KDTreeFirstImpl,buildNodes){
     KDTreeFirstImpl kdTree;
     std::vector<KDTreeElement> elements = {
                 KDTreeElement {0.5,1},
@@ -113,23 +121,53 @@ TEST(KDTreeFirstImpl,buildTree){
                 KDTreeElement {4  ,8},
                 KDTreeElement {444444  ,888888}
             };
-    auto elementsPtrs = elementsToPtrs(elements);
-    auto rootId = kdTree.buildTree(elementsPtrs.begin(),elementsPtrs.end());
+    kdTree.setNewElements(elementsToPtrs(elements));
     auto &nodes = kdTree.nodes;
-    EXPECT_EQ(nodes.size(), elements.size());
-    auto rootNode = nodes.at(rootId);
-    EXPECT_EQ(*rootNode.element,KDTreeElement (3 ,5));
-    auto rootLeft = nodes.at(rootNode.leftChildId);
-    EXPECT_EQ(*rootLeft.element,KDTreeElement (1 ,2));
-    auto rootLeftLeft = nodes.at(rootLeft.leftChildId);
-    EXPECT_EQ(*rootLeftLeft.element,KDTreeElement (0.5 ,1));
-    auto rootLeftRight = nodes.at(rootLeft.rightChildId);
-    EXPECT_EQ(*rootLeftRight.element,KDTreeElement (2 ,4));
-    auto rootRight = nodes.at(rootNode.rightChildId);
-    EXPECT_EQ(*rootRight.element,KDTreeElement (444444  ,888888));
-    auto rootRightLeft = nodes.at(rootRight.leftChildId);
-    EXPECT_EQ(*rootRightLeft.element,KDTreeElement (4  ,8 ));
+    ASSERT_EQ(nodes.size(), elements.size());
+    //Preorder: root is first, its left subtree takes next size/2 ids and right subtree the rest
+    EXPECT_EQ(*nodes.at(0).element,KDTreeElement (3 ,5));
+    EXPECT_EQ(nodes.at(0).leftChildId,1);
+    EXPECT_EQ(nodes.at(0).rightChildId,4);
+    EXPECT_EQ(*nodes.at(1).element,KDTreeElement (1 ,2));
+    EXPECT_EQ(nodes.at(1).leftChildId,2);
+    EXPECT_EQ(nodes.at(1).rightChildId,3);
+    EXPECT_EQ(*nodes.at(2).element,KDTreeElement (0.5 ,1));
+    EXPECT_EQ(*nodes.at(3).element,KDTreeElement (2 ,4));
+    EXPECT_EQ(*nodes.at(4).element,KDTreeElement (444444  ,888888));
+    EXPECT_EQ(nodes.at(4).leftChildId,5);
+    EXPECT_EQ(nodes.at(4).rightChildId,-1);
+    EXPECT_EQ(*nodes.at(5).element,KDTreeElement (4  ,8 ));
+    for(int id: {2,3,5}){
+        EXPECT_EQ(nodes.at(id).leftChildId,-1);
+        EXPECT_EQ(nodes.at(id).rightChildId,-1);
+    }
+}
 
+TEST(KDTreeFirstImpl,parallelBuild){
+    srand(11);
+    std::vector<KDTreeElement> elements;
+    for(int i=0;i<300000;i++){
+        //Coarse grid so that there are duplicates and many equal coordinates
+        elements.push_back(KDTreeElement(rand()%1000,rand()%1000));
+    }
+    auto elementsPtrs = elementsToPtrs(elements);
+    std::random_shuffle(elementsPtrs.begin(),elementsPtrs.end());
+    KDTreeFirstImpl serialKDTree;
+    serialKDTree.setNewElements(elementsPtrs);
+    for(int threadsNumber: {2,3,8}){
+        KDTreeFirstImpl kdTree;
+        kdTree.setBuildThreadsNumber(threadsNumber);
+        kdTree.setNewElements(elementsPtrs);
+        ASSERT_EQ(kdTree.nodes.size(),serialKDTree.nodes.size());
+        for(int i=0;i<kdTree.nodes.size();i++){
+            ASSERT_EQ(kdTree.nodes.at(i).element,serialKDTree.nodes.at(i).element);
+            ASSERT_EQ(kdTree.nodes.at(i).leftChildId,serialKDTree.nodes.at(i).leftChildId);
+            ASSERT_EQ(kdTree.nodes.at(i).rightChildId,serialKDTree.nodes.at(i).rightChildId);
+            ASSERT_EQ(kdTree.nodes.at(i).sameValueBegin,serialKDTree.nodes.at(i).sameValueBegin);
+            ASSERT_EQ(kdTree.nodes.at(i).sameValueCount,serialKDTree.nodes.at(i).sameValueCount);
+        }
+        EXPECT_EQ(kdTree.sortedElements,serialKDTree.sortedElements);
+    }
 }
 
 class KDTreeFirstImplFiveElementsOnSameLine: public  ::testing::Test {
@@ -245,4 +283,143 @@ TEST(KDTreeFirstImplTest, Clear)
 
     EXPECT_TRUE(kdTree->getElementsClosestTo(&referenceElement).size() == 0);
 }
+class KDTreeFirstImplRandomElements: public  ::testing::Test {
+    protected:
+    void SetUp() override {
+        elements = makeRandomGridElements(2000,200,-50,7);
+        elementsPtr = elementsToPtrs(elements);
+        kdTree.setNewElements(elementsPtr);
+    }
+    KDTreeFirstImpl kdTree;
+    std::vector<KDTreeElement*> elementsPtr;
+    std::vector<KDTreeElement> elements;
+};
+
+TEST_F(KDTreeFirstImplRandomElements,getKNearest)
+{
+    for(int i=0;i<50;i++){
+        KDTreeElement referenceElement(rand()%300 - 100,rand()%300 - 100);
+        auto allDistances = getSortedDistances(elementsPtr,referenceElement);
+        for(int k: {1,2,7,64}){
+            auto nearestElements = kdTree.getKNearest(&referenceElement,k);
+            ASSERT_EQ(nearestElements.size(),k);
+            auto distances = getDistances(nearestElements,referenceElement);
+            EXPECT_TRUE(std::is_sorted(distances.begin(),distances.end()));
+            EXPECT_EQ(distances,std::vector<double>(allDistances.begin(),allDistances.begin()+k));
+            EXPECT_EQ(std::set<KDTreeElement*>(nearestElements.begin(),nearestElements.end()).size(),k);
+        }
+    }
+    KDTreeElement referenceElement(0,0);
+    EXPECT_EQ(kdTree.getKNearest(&referenceElement,0).size(),0);
+    EXPECT_EQ(kdTree.getKNearest(&referenceElement,5000).size(),elementsPtr.size());
+}
+
+TEST_F(KDTreeFirstImplRandomElements,getWithinRadius)
+{
+    for(int i=0;i<50;i++){
+        KDTreeElement referenceElement(rand()%300 - 100,rand()%300 - 100);
+        double radius = rand()%40;
+        auto expectedElements = getWithinRadiusBruteForce(elementsPtr,referenceElement,radius);
+        std::vector<KDTreeElement*> result{nullptr};
+        kdTree.getWithinRadius(&referenceElement,radius,result);
+        //Result is appended to buffer
+        ASSERT_EQ(result.front(),nullptr);
+        result.erase(result.begin());
+        EXPECT_EQ(std::set<KDTreeElement*>(result.begin(),result.end()),std::set<KDTreeElement*>(expectedElements.begin(),expectedElements.end()));
+        EXPECT_EQ(result.size(),expectedElements.size());
+    }
+}
+TEST_F(KDTreeFirstImplRandomElements,concurrentQueriesWithTrace)
+{
+    std::vector<KDTreeElement> queries;
+    for(int i=0;i<400;i++){
+        queries.push_back(KDTreeElement(rand()%300 - 100,rand()%300 - 100));
+    }
+    const KDTree &constKDTree = kdTree;
+    std::vector<std::vector<KDTreeElement*>> expectedResults;
+    for(auto &query: queries){
+        expectedResults.push_back(constKDTree.getKNearest(&query,5));
+    }
+    std::vector<std::vector<std::vector<KDTreeElement*>>> results(4,std::vector<std::vector<KDTreeElement*>>(queries.size()));
+    std::vector<std::thread> threads;
+    for(int t=0;t<4;t++){
+        threads.push_back(std::thread([&,t](){
+            for(int i=0;i<queries.size();i++){
+                results.at(t).at(i) = constKDTree.getKNearest(&queries.at(i),5);
+            }
+        }));
+    }
+    for(auto &thread: threads){
+        thread.join();
+    }
+    for(int t=0;t<4;t++){
+        EXPECT_EQ(results.at(t),expectedResults);
+    }
+
+    KDTreeSearchTrace trace;
+    constKDTree.getElementsClosestTo(&queries.front(),&trace);
+    EXPECT_GT(trace.visitedAABBs.size(),0);
+    EXPECT_LT(trace.visitedAABBs.size(),elementsPtr.size());
+    //Trace is cleared by the next query
+    auto visitedAABBsNumber = trace.visitedAABBs.size();
+    constKDTree.getElementsClosestTo(&queries.front(),&trace);
+    EXPECT_EQ(trace.visitedAABBs.size(),visitedAABBsNumber);
+}
+
+TEST_F(KDTreeFirstImplRandomElements,getNearestBatch)
+{
+    std::vector<KDTreeElement> queries;
+    for(int i=0;i<1000;i++){
+        queries.push_back(KDTreeElement(rand()%300 - 100,rand()%300 - 100));
+    }
+    for(int threadsNumber: {1,3,8}){
+        //Pool is reused by several batches
+        ParallelForPool pool(threadsNumber);
+        for(int batch=0;batch<2;batch++){
+            std::vector<KDTreeElement*> results{nullptr};
+            kdTree.getNearestBatch(queries,results,&pool);
+            ASSERT_EQ(results.size(),queries.size());
+            for(int i=0;i<queries.size();i++){
+                auto closestElements = kdTree.getElementsClosestTo(&queries.at(i));
+                ASSERT_NE(results.at(i),nullptr);
+                EXPECT_EQ((*results.at(i) - queries.at(i)).length(),(*closestElements.front() - queries.at(i)).length());
+            }
+        }
+    }
+    KDTreeFirstImpl emptyKDTree;
+    std::vector<KDTreeElement*> results;
+    emptyKDTree.getNearestBatch(queries,results);
+    EXPECT_EQ(results,std::vector<KDTreeElement*>(queries.size(),nullptr));
+}
+
+TEST_F(KDTreeFirstImplRandomElements,approximateSearch)
+{
+    for(double epsilon: {0.1,0.5,1.0}){
+        kdTree.setApproximation(epsilon);
+        for(int i=0;i<50;i++){
+            KDTreeElement referenceElement(rand()%300 - 100,rand()%300 - 100);
+            auto allDistances = getSortedDistances(elementsPtr,referenceElement);
+            auto closestElements = kdTree.getElementsClosestTo(&referenceElement);
+            ASSERT_GT(closestElements.size(),0);
+            EXPECT_LE((*closestElements.front() - referenceElement).length(),(1 + epsilon) * allDistances.front() + 1e-4);
+            for(int k: {1,7,64}){
+                auto nearestElements = kdTree.getKNearest(&referenceElement,k);
+                ASSERT_EQ(nearestElements.size(),k);
+                auto distances = getSortedDistances(nearestElements,referenceElement);
+                for(int j=0;j<k;j++){
+                    EXPECT_LE(distances.at(j),(1 + epsilon) * allDistances.at(j) + 1e-4);
+                }
+            }
+        }
+    }
+    KDTreeElement referenceElement(50,50);
+    kdTree.setApproximation(0,5);
+    EXPECT_LT(kdTree.getKNearest(&referenceElement,64).size(),64);
+    EXPECT_GT(kdTree.getElementsClosestTo(&referenceElement).size(),0);
+    kdTree.setApproximation(0);
+    auto allDistances = getSortedDistances(elementsPtr,referenceElement);
+    EXPECT_EQ(getSortedDistances(kdTree.getKNearest(&referenceElement,64),referenceElement),
+              std::vector<double>(allDistances.begin(),allDistances.begin()+64));
+}
+
 #endif //KD_TREE_TEST_H
@@ -0,0 +1,92 @@
+#ifndef KD_TREE_TEST_UTILS_H
+#define KD_TREE_TEST_UTILS_H
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../KDTree/kd_tree.h"
+
+//Random data and brute force answers shared by KD tree tests
+
+//Coordinates are integers in [offset, offset + range), so coarse grid gives duplicates and equal distances
+inline std::vector<KDTreeElement> makeRandomGridElements(int number, int range, int offset, unsigned seed){
+    srand(seed);
+    std::vector<KDTreeElement> elements;
+    for(int i=0;i<number;i++){
+        elements.push_back(KDTreeElement(rand()%range + offset,rand()%range + offset));
+    }
+    return elements;
+}
+
+//The same for any fixed size array of coordinates
+template <class POINT>
+std::vector<POINT> makeRandomGridPoints(int number, int range, int offset, unsigned seed){
+    srand(seed);
+    std::vector<POINT> points(number);
+    for(auto &point: points){
+        for(auto &coordinate: point){
+            coordinate = rand()%range + offset;
+        }
+    }
+    return points;
+}
+
+inline std::vector<KDTreeElement*> elementsToPtrs(std::vector<KDTreeElement> &elements){
+    std::vector<KDTreeElement*> elementsPtrs;
+    for(auto &element: elements){
+        elementsPtrs.push_back(&element);
+    }
+    return elementsPtrs;
+}
+
+//Distances in order of elements
+inline std::vector<double> getDistances(const std::vector<KDTreeElement*> &elements, const KDTreeElement &referenceElement){
+    std::vector<double> distances;
+    for(auto element: elements){
+        distances.push_back((*element - referenceElement).length());
+    }
+    return distances;
+}
+
+inline std::vector<double> getSortedDistances(const std::vector<KDTreeElement*> &elements, const KDTreeElement &referenceElement){
+    auto distances = getDistances(elements,referenceElement);
+    std::sort(distances.begin(),distances.end());
+    return distances;
+}
+
+inline std::vector<KDTreeElement*> getWithinRadiusBruteForce(const std::vector<KDTreeElement*> &elements, const KDTreeElement &referenceElement, double radius){
+    std::vector<KDTreeElement*> result;
+    for(auto element: elements){
+        if((*element - referenceElement).length() <= radius) result.push_back(element);
+    }
+    return result;
+}
+
+//Expects closest, k nearest and within radius queries of kdTree to agree with referenceKDTree
+inline void expectSameQueryResults(const KDTree &kdTree, const KDTree &referenceKDTree, const KDTreeElement &referenceElement, double radius){
+    auto closestElements = kdTree.getElementsClosestTo(&referenceElement);
+    auto expectedClosestElements = referenceKDTree.getElementsClosestTo(&referenceElement);
+    ASSERT_EQ(closestElements.empty(),expectedClosestElements.empty());
+    if(!closestElements.empty()){
+        //Closest elements may differ when several values are equally close
+        EXPECT_EQ(getDistances(closestElements,referenceElement).front(),getDistances(expectedClosestElements,referenceElement).front());
+        //All returned elements have the same value
+        for(auto element: closestElements){
+            EXPECT_EQ(*element,*closestElements.front());
+        }
+        EXPECT_EQ(closestElements.size(),referenceKDTree.getElementsClosestTo(closestElements.front()).size());
+    }
+    for(int k: {1,5,32}){
+        EXPECT_EQ(getDistances(kdTree.getKNearest(&referenceElement,k),referenceElement),
+                  getDistances(referenceKDTree.getKNearest(&referenceElement,k),referenceElement));
+    }
+    std::vector<KDTreeElement*> result, expectedResult;
+    kdTree.getWithinRadius(&referenceElement,radius,result);
+    referenceKDTree.getWithinRadius(&referenceElement,radius,expectedResult);
+    EXPECT_EQ(std::set<KDTreeElement*>(result.begin(),result.end()),std::set<KDTreeElement*>(expectedResult.begin(),expectedResult.end()));
+}
+
+#endif // KD_TREE_TEST_UTILS_H
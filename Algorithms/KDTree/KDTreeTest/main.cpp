@@ -1,5 +1,8 @@
 #include "kd_tree_test.h"
 #include "aabb_test.h"
+#include "kd_tree_implicit_test.h"
+#include "kd_tree_generic_test.h"
+#include "kd_tree_dynamic_test.h"
 
 #include <gtest/gtest.h>
 
@@ -3,4 +3,5 @@ TEMPLATE = subdirs
 
 SUBDIRS += \
     QuadTreeTests \
+    QuadTreeOracle \
     QuadTree
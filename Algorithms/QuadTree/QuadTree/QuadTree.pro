@@ -6,6 +6,7 @@ QMAKE_LFLAGS_RELEASE -= -s
 QT       += core gui
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+CONFIG += thread
 
 TARGET = QuadTreeCPP
 TEMPLATE = app
@@ -21,14 +22,27 @@ DEFINES += QT_DEPRECATED_WARNINGS
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# Store leaf elements bounding boxes as 8 or 16 bit offsets relative to leaf bounds in QuadTreeFast.
+#DEFINES += QUAD_TREE_LEAF_QUANTIZATION_BITS=8
+
 
 HEADERS += \
     main_window.h \
     quad_tree.h \
+    quad_tree_brute_force.h \
+    quad_tree_dynamic.h \
+    quad_tree_element_pool.h \
     quad_tree_benchmark.h \
     quad_tree_fast.h \
     quad_tree_moderate.h \
+    quad_tree_oracle.h \
+    quad_tree_orthant.h \
+    quad_tree_parallel.h \
+    quad_tree_perf_counters.h \
+    quad_tree_pair_manager.h \
+    quad_tree_simulation.h \
     quad_tree_slow.h \
+    quad_tree_str.h \
     quad_tree_widget.h
 
 SOURCES += \
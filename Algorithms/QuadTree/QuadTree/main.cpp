@@ -13,7 +13,6 @@ int main(int argc, char *argv[])
 {
     bool benchmark = true;
     if(benchmark){
-        QuadTree<NUM> *quadTree;
 //        quadTree = new QuadTreeModerate<NUM>();
 //                QuadTreeBenchmark<NUM>().testQuadTree(
 //                            quadTree,
@@ -28,20 +27,76 @@ int main(int argc, char *argv[])
 //                            AABB<NUM>(0,0,9999,9999)
 //                        );
 //        delete quadTree;
-        quadTree = new QuadTreeFast<NUM>();
-                QuadTreeBenchmark<NUM>().testQuadTree(
-                            quadTree,
-                            50,
-                            9900,
-                            {
-                                QUAD_TREE_BENCHMARK_TYPE::SET_ELEMENTS,
-                                QUAD_TREE_BENCHMARK_TYPE::GET_ALL_OVERLAPPING_TUPLES,
-                                QUAD_TREE_BENCHMARK_TYPE::GET_OVERLAPPING_ELEMENTS},
-                            10,
-                            10,
-                            AABB<NUM>(0,0,1999,1999)
-                        );
-        delete quadTree;
+        //Same tree with elements sorted in Hilbert order before build
+        QuadTreeFast<NUM> *hilbertQuadTree = new QuadTreeFast<NUM>();
+        hilbertQuadTree->setHilbertOrder(true,4);
+        vector<QuadTree<NUM>*> quadTrees{
+            new QuadTreeModerate<NUM>(),
+            new QuadTreeFast<NUM>(),
+            new STRTree<NUM>(16),
+            new DynamicAABBTree<NUM>(),
+            hilbertQuadTree};
+        QuadTreeBenchmark<NUM>(true).compareQuadTrees(
+                    quadTrees,
+                    50,
+                    9900,
+                    {
+                        QUAD_TREE_BENCHMARK_TYPE::SET_ELEMENTS,
+                        QUAD_TREE_BENCHMARK_TYPE::GET_ALL_OVERLAPPING_TUPLES,
+                        QUAD_TREE_BENCHMARK_TYPE::GET_OVERLAPPING_ELEMENTS},
+                    10,
+                    10,
+                    AABB<NUM>(0,0,1999,1999)
+                );
+        QuadTreeBenchmark<NUM>().testPairManager(
+                    quadTrees.at(1),
+                    50,
+                    9900,
+                    2,
+                    10,
+                    10,
+                    AABB<NUM>(0,0,1999,1999)
+                );
+        for(auto quadTree: quadTrees){
+            delete quadTree;
+        }
+        //Power of two root box of integral tree is split with shifts, the same root is built with generic split for comparison
+        QuadTreeFast<NUM> *genericSplitQuadTree = new QuadTreeFast<NUM>();
+        genericSplitQuadTree->setPowerOfTwoSplit(false);
+        vector<QuadTree<NUM>*> powerOfTwoQuadTrees{
+            new QuadTreeFast<NUM>(),
+            genericSplitQuadTree};
+        QuadTreeBenchmark<NUM>().compareQuadTrees(
+                    powerOfTwoQuadTrees,
+                    50,
+                    9900,
+                    {QUAD_TREE_BENCHMARK_TYPE::SET_ELEMENTS},
+                    10,
+                    10,
+                    AABB<NUM>(0,0,2048,2048)
+                );
+        for(auto quadTree: powerOfTwoQuadTrees){
+            delete quadTree;
+        }
+        QuadTreeBenchmark<NUM>().testOrthantTree<3>(
+                    50,
+                    9900,
+                    {
+                        QUAD_TREE_BENCHMARK_TYPE::SET_ELEMENTS,
+                        QUAD_TREE_BENCHMARK_TYPE::GET_ALL_OVERLAPPING_TUPLES,
+                        QUAD_TREE_BENCHMARK_TYPE::GET_OVERLAPPING_ELEMENTS},
+                    6,
+                    10,
+                    AABBN<NUM,3>({0,0,0},{1999,1999,1999})
+                );
+        //Collision response and integration of moving boxes, tree rebuild stays serial
+        benchmarkElementsHolder(
+                    20,
+                    500000,
+                    {1,2,4,8},
+                    10,
+                    AABB<NUM>(0,0,3999,3999)
+                );
     }else{
         QApplication a(argc, argv);
         MainWindow w;
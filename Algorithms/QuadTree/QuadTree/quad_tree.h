@@ -7,8 +7,23 @@
 #include <vector>
 #include <tuple>
 #include <ctime>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <type_traits>
 
+//Number of bits used per coordinate to store leaf elements bounding boxes of OrthantTreeFast in compressed form (0, 8 or 16)
+//0 disables compression
+#ifndef QUAD_TREE_LEAF_QUANTIZATION_BITS
+#define QUAD_TREE_LEAF_QUANTIZATION_BITS 0
+#endif
+
+//When set to 1 OrthantTreeFast (and so QuadTreeFast) and QuadTreeModerate count work done by getAllOverlappingElements and getAllOverlappingElementTuples
+//0 compiles counting out
+#ifndef QUAD_TREE_QUERY_COUNTERS
+#define QUAD_TREE_QUERY_COUNTERS 0
+#endif
+
 using std::vector;
 using std::array;
 using std::shared_ptr;
@@ -48,6 +63,18 @@ struct AABB{
             AABB<T>(xMin,yMin,xCtr,yCtr)
         };
     }
+    //Same as split for integral T and box with power of two sides, center is found with shifts
+    array<AABB<T>,4> splitPowerOfTwo() const {
+        static_assert(std::is_integral<T>::value, "splitPowerOfTwo requires integral coordinates");
+        T xCtr = xMin+((xMax - xMin) >> 1);
+        T yCtr = yMin+((yMax - yMin) >> 1);
+        return array<AABB<T>,4>{
+            AABB<T>(xCtr,yCtr,xMax,yMax),
+            AABB<T>(xCtr,yMin,xMax,yCtr),
+            AABB<T>(xMin,yCtr,xCtr,yMax),
+            AABB<T>(xMin,yMin,xCtr,yCtr)
+        };
+    }
     void translateBy(T dx,T dy){
         xMin+=dx;
         xMax+=dx;
@@ -63,6 +90,71 @@ struct AABB{
     }
 };
 
+//Axis aligned bounding box stored as offsets relative to reference box with Q precision
+//Rounded outward so it always covers original box, hence if two quantized boxes don't overlap originals don't overlap too
+template <class Q, typename std::enable_if<std::is_integral<Q>::value && std::is_unsigned<Q>::value>::type* = nullptr>
+struct QuantizedAABB{
+    QuantizedAABB():xMin(0),yMin(0),xMax(0),yMax(0){}
+    template <class T>
+    QuantizedAABB(const AABB<T> &aabb, const AABB<T> &referenceBox):
+        xMin(quantizeDown(aabb.xMin,referenceBox.xMin,referenceBox.xMax)),
+        yMin(quantizeDown(aabb.yMin,referenceBox.yMin,referenceBox.yMax)),
+        xMax(quantizeUp(aabb.xMax,referenceBox.xMin,referenceBox.xMax)),
+        yMax(quantizeUp(aabb.yMax,referenceBox.yMin,referenceBox.yMax)){}
+    Q xMin,yMin,xMax,yMax;
+    // Note: touching boxes are considered overlapping to stay conservative after rounding
+    bool mayOverlap(const QuantizedAABB &another)const{
+        return this->xMax >= another.xMin && another.xMax >= this->xMin && this->yMax >= another.yMin && another.yMax >= this->yMin;
+    }
+    //Coordinate in [min,max] to Q, rounded down or up. Shared with QuantizedAABBN
+    static Q quantizeDown(double value, double min, double max){
+        return clamp(std::floor(scale(value,min,max)));
+    }
+    static Q quantizeUp(double value, double min, double max){
+        return clamp(std::ceil(scale(value,min,max)));
+    }
+private:
+    static double scale(double value, double min, double max){
+        if(max <= min) return 0;
+        return (value - min) / (max - min) * std::numeric_limits<Q>::max();
+    }
+    static Q clamp(double value){
+        if(value < 0) return 0;
+        if(value > std::numeric_limits<Q>::max()) return std::numeric_limits<Q>::max();
+        return static_cast<Q>(value);
+    }
+};
+
+//Structural statistics of built tree
+struct QuadTreeStats{
+    int nodesNumber = 0;
+    int leavesNumber = 0;
+    //Elements are counted once per node they are stored in
+    int elementReferencesNumber = 0;
+    //Memory of leaf entries scanned during leaf overlap tests, including ids stored next to bounding boxes
+    size_t leafBoxesBytes = 0;
+    int leafQuantizationBits = 0;
+};
+
+//Work done by queries since last resetQueryStats, filled only when QUAD_TREE_QUERY_COUNTERS is enabled.
+//Every query counts into its own copy and adds it to tree stats once, so const queries may run concurrently
+struct QuadTreeQueryStats{
+    long long nodesVisited = 0;
+    long long leavesVisited = 0;
+    //Pairs of elements checked with doesOverlap
+    long long candidatePairs = 0;
+    long long emittedPairs = 0;
+    //Part of emitted pairs reported without check because one element covers node of the other
+    long long ancestorPairs = 0;
+    void add(const QuadTreeQueryStats &other){
+        nodesVisited += other.nodesVisited;
+        leavesVisited += other.leavesVisited;
+        candidatePairs += other.candidatePairs;
+        emittedPairs += other.emittedPairs;
+        ancestorPairs += other.ancestorPairs;
+    }
+};
+
 //Inherit this class for object to be used with quad tree
 template <class T>
 struct QuadTreeElement{
@@ -115,12 +207,23 @@ public:
     virtual vector<tuple<ELEMENT_PTR,ELEMENT_PTR>> getAllOverlappingElementTuples() const=0;
     virtual void reset()=0;
     virtual const QuadTreeVisualionHelper<T> *getVisualisationHelper() const=0;
+    virtual QuadTreeStats getStats() const{
+        return QuadTreeStats();
+    }
+    virtual QuadTreeQueryStats getQueryStats() const{
+        return QuadTreeQueryStats();
+    }
+    virtual void resetQueryStats(){}
 };
 
 template <class T>
 class QuadTreeVisualionHelper{
 public:
     virtual vector<AABB<T>> getNonLeafNodesBoundingBoxes() const=0;
+    //Nodes split at their centre are drawn as crosses, others as their boxes
+    virtual bool areNodesSplitAtCenter() const{
+        return true;
+    }
 };
 
 #endif // QUADTREE_H
@@ -4,13 +4,23 @@
 #include <chrono>
 #include <set>
 #include <cmath>
+#include <memory>
+#include <iterator>
 
 #include "quad_tree.h"
 #include "quad_tree_slow.h"
 #include "quad_tree_moderate.h"
+#include "quad_tree_fast.h"
+#include "quad_tree_str.h"
+#include "quad_tree_dynamic.h"
+#include "quad_tree_pair_manager.h"
+#include "quad_tree_orthant.h"
+#include "quad_tree_element_pool.h"
+#include "quad_tree_perf_counters.h"
 
 enum QUAD_TREE_BENCHMARK_TYPE{SET_ELEMENTS,GET_OVERLAPPING_ELEMENTS,GET_ALL_OVERLAPPING_TUPLES};
 
+//Elements made by makeElements are owned by generator and live as long as it does
 template <class T>
 class QuadTreeDataGenerator{
 public:
@@ -34,10 +44,30 @@ public:
             T y = boundingBox.yMin + std::fmod(rand(),boundingBoxHeight);
             T width = minSize + std::fmod(rand(),(maxSize-minSize));
             T height = minSize + std::fmod(rand(),(maxSize-minSize));
-            elements.at(i) = QuadTreeElement<T>::makeElement(AABB<T>(x,y,x+width,y+height));
+            elements.at(i) = elementsPool.make(AABB<T>(x,y,x+width,y+height));
         }
         return  elements;
     }
+    template <int D>
+    vector<OrthantTreeElement<T,D>*> makeOrthantElements(int numberOfElements,
+                                                         const AABBN<T,D> &boundingBox,
+                                                         T minSize = 10,
+                                                         T maxSize = 50)
+    {
+        vector<OrthantTreeElement<T,D>*> elements(numberOfElements);
+        for(int i=0;i<numberOfElements;i++){
+            AABBN<T,D> aabb;
+            for(int j=0;j<D;j++){
+                aabb.min[j] = boundingBox.min[j] + std::fmod(rand(),boundingBox.max[j] - boundingBox.min[j]);
+                aabb.max[j] = aabb.min[j] + minSize + std::fmod(rand(),(maxSize-minSize));
+            }
+            elements.at(i) = OrthantTreeElement<T,D>::makeElement(aabb);
+        }
+        return  elements;
+    }
+
+protected:
+    QuadTreeElementPool<QuadTreeElement<T>> elementsPool;
 };
 
 template <class T>
@@ -47,6 +77,8 @@ public:
     typedef typename QuadTree<T>::ELEMENT_PTR ELEMENT_PTR;
 
 public:
+    //With usePerfCounters hardware counters of every benchmark type are printed per element
+    QuadTreeBenchmark(bool usePerfCounters = false):usePerfCounters(usePerfCounters){}
     void testQuadTree(QuadTree<T>* quadTree,
                       int numberOfTests,
                       int numberOfElements,
@@ -60,52 +92,264 @@ public:
                       T minSize = 10,
                       T maxSize = 50 ) const
     {
-        std::string typeName = typeid(*quadTree).name();
-        std::cout<<"Performing "<<numberOfTests<<" test on '"<<typeName<<"' with "<<numberOfElements<<" elements..."<<std::endl;
-
-        ELEMENTS_PTR elements = QuadTreeDataGenerator<T>().makeElements(
+        QuadTreeDataGenerator<T> generator;
+        ELEMENTS_PTR elements = generator.makeElements(
                     numberOfElements,
                     boundingBox,
                     minSize,
                     maxSize);
+        testQuadTree(quadTree,numberOfTests,elements,benchmarkTypes,treeDepth,maxElementsPerBox,boundingBox);
+    }
+    //All trees are tested on the same data
+    void compareQuadTrees(const vector<QuadTree<T>*> &quadTrees,
+                          int numberOfTests,
+                          int numberOfElements,
+                          std::set<QUAD_TREE_BENCHMARK_TYPE> benchmarkTypes = {
+                                QUAD_TREE_BENCHMARK_TYPE::SET_ELEMENTS,
+                                QUAD_TREE_BENCHMARK_TYPE::GET_OVERLAPPING_ELEMENTS,
+                                QUAD_TREE_BENCHMARK_TYPE::GET_ALL_OVERLAPPING_TUPLES},
+                          int treeDepth = 6,
+                          int maxElementsPerBox = 6,
+                          const AABB<T> &boundingBox = AABB<T>(0,0,799,799),
+                          T minSize = 10,
+                          T maxSize = 50 ) const
+    {
+        QuadTreeDataGenerator<T> generator;
+        ELEMENTS_PTR elements = generator.makeElements(
+                    numberOfElements,
+                    boundingBox,
+                    minSize,
+                    maxSize);
+        for(auto quadTree: quadTrees){
+            testQuadTree(quadTree,numberOfTests,elements,benchmarkTypes,treeDepth,maxElementsPerBox,boundingBox);
+        }
+    }
+    void testQuadTree(QuadTree<T>* quadTree,
+                      int numberOfTests,
+                      const ELEMENTS_PTR &elements,
+                      std::set<QUAD_TREE_BENCHMARK_TYPE> benchmarkTypes,
+                      int treeDepth,
+                      int maxElementsPerBox,
+                      const AABB<T> &boundingBox) const
+    {
+        std::string typeName = typeid(*quadTree).name();
+        std::cout<<"Performing "<<numberOfTests<<" test on '"<<typeName<<"' with "<<elements.size()<<" elements..."<<std::endl;
+
         quadTree->setElements(elements,boundingBox, treeDepth, maxElementsPerBox);
+        printQuadTreeStats(quadTree);
+
+        std::unique_ptr<QuadTreePerfCounters> perfCounters;
+        if(usePerfCounters) perfCounters.reset(new QuadTreePerfCounters());
 
         std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
         if(benchmarkTypes.count(QUAD_TREE_BENCHMARK_TYPE::SET_ELEMENTS)>0){
+            /*
+             * Dynamic tree only refits proxies that stay inside their fat boxes, so unmoved elements would cost it a lookup each.
+             * Elements are shifted back and forth by more than fat margin before every call to make it reinsert all of them
+             * like other trees rebuild, shifting is timed too
+             */
+            DynamicAABBTree<T> *dynamicTree = dynamic_cast<DynamicAABBTree<T>*>(quadTree);
+            T shift = dynamicTree != nullptr ? dynamicTree->getFatMargin() + 1 : 0;
+            if(dynamicTree != nullptr) std::cout<<"   Elements are moved by "<<shift<<" before every setElements"<<std::endl;
             std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+            startPerfCounters(perfCounters.get());
             for(int i=0;i<numberOfTests;i++){
+                if(dynamicTree != nullptr) translateElements(elements,i%2 == 0 ? shift : -shift);
                 quadTree->setElements(elements,boundingBox, treeDepth, maxElementsPerBox);
             }
+            stopPerfCounters(perfCounters.get());
             std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+            if(dynamicTree != nullptr && numberOfTests%2 == 1){
+                translateElements(elements,-shift);
+                quadTree->setElements(elements,boundingBox, treeDepth, maxElementsPerBox);
+            }
             auto duration = std::chrono::duration_cast<std::chrono::milliseconds>( t2 - t1 ).count();
             std::cout<<"setElements took "<<duration<<" miliseconds. Average: "<<(double) duration/(double) numberOfTests<<" ms per single test"<<std::endl;
+            printPerfCounters(perfCounters.get(),numberOfTests,elements.size());
         }
         if(benchmarkTypes.count(QUAD_TREE_BENCHMARK_TYPE::GET_OVERLAPPING_ELEMENTS)>0){
             std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+            startPerfCounters(perfCounters.get());
             for(int i=0;i<numberOfTests;i++){
                 volatile int overlappingElementsNum = quadTree->getAllOverlappingElements().size();
             }
+            stopPerfCounters(perfCounters.get());
             std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
             auto duration = std::chrono::duration_cast<std::chrono::milliseconds>( t2 - t1 ).count();
             std::cout<<"getElementsThatOverlap took "<<duration<<" miliseconds. Average: "<<(double) duration/(double) numberOfTests<<" ms per single test"<<std::endl;
+            printPerfCounters(perfCounters.get(),numberOfTests,elements.size());
         }
         if(benchmarkTypes.count(QUAD_TREE_BENCHMARK_TYPE::GET_ALL_OVERLAPPING_TUPLES)>0){
             std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+            startPerfCounters(perfCounters.get());
             for(int i=0;i<numberOfTests;i++){
                 volatile int overlappingElementsNum = quadTree->getAllOverlappingElementTuples().size();
             }
+            stopPerfCounters(perfCounters.get());
             std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
             auto duration = std::chrono::duration_cast<std::chrono::milliseconds>( t2 - t1 ).count();
             std::cout<<"getAllOverlappingElementTuples "<<duration<<" miliseconds. Average: "<<(double) duration/(double) numberOfTests<<" ms per single test"<<std::endl;
+            printPerfCounters(perfCounters.get(),numberOfTests,elements.size());
         }
     }
 
+    //Same measurements as testQuadTree for orthant tree of any dimension
+    template <int D>
+    void testOrthantTree(int numberOfTests,
+                         int numberOfElements,
+                         std::set<QUAD_TREE_BENCHMARK_TYPE> benchmarkTypes,
+                         int treeDepth,
+                         int maxElementsPerBox,
+                         const AABBN<T,D> &boundingBox,
+                         T minSize = 10,
+                         T maxSize = 50) const
+    {
+        OrthantTreeFast<T,D> tree;
+        auto elements = QuadTreeDataGenerator<T>().template makeOrthantElements<D>(
+                    numberOfElements,
+                    boundingBox,
+                    minSize,
+                    maxSize);
+        std::cout<<"Performing "<<numberOfTests<<" test on '"<<typeid(tree).name()<<"' with "<<elements.size()<<" elements in "<<D<<" dimensions..."<<std::endl;
+
+        tree.setElements(elements,boundingBox, treeDepth, maxElementsPerBox);
+        QuadTreeStats stats = tree.getStats();
+        std::cout<<"   Nodes: "<<stats.nodesNumber<<
+                   ", leafs: "<<stats.leavesNumber<<
+                   ", element references: "<<stats.elementReferencesNumber<<std::endl;
+        if(benchmarkTypes.count(QUAD_TREE_BENCHMARK_TYPE::SET_ELEMENTS)>0){
+            std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+            for(int i=0;i<numberOfTests;i++){
+                tree.setElements(elements,boundingBox, treeDepth, maxElementsPerBox);
+            }
+            std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>( t2 - t1 ).count();
+            std::cout<<"setElements took "<<duration<<" miliseconds. Average: "<<(double) duration/(double) numberOfTests<<" ms per single test"<<std::endl;
+        }
+        if(benchmarkTypes.count(QUAD_TREE_BENCHMARK_TYPE::GET_OVERLAPPING_ELEMENTS)>0){
+            std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+            for(int i=0;i<numberOfTests;i++){
+                volatile int overlappingElementsNum = tree.getAllOverlappingElements().size();
+            }
+            std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>( t2 - t1 ).count();
+            std::cout<<"getAllOverlappingElements took "<<duration<<" miliseconds. Average: "<<(double) duration/(double) numberOfTests<<" ms per single test"<<std::endl;
+        }
+        if(benchmarkTypes.count(QUAD_TREE_BENCHMARK_TYPE::GET_ALL_OVERLAPPING_TUPLES)>0){
+            std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+            for(int i=0;i<numberOfTests;i++){
+                volatile int overlappingElementsNum = tree.getAllOverlappingElementTuples().size();
+            }
+            std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>( t2 - t1 ).count();
+            std::cout<<"getAllOverlappingElementTuples "<<duration<<" miliseconds. Average: "<<(double) duration/(double) numberOfTests<<" ms per single test"<<std::endl;
+        }
+        for(auto element: elements){
+            delete element;
+        }
+    }
+
+    /*
+     * Elements are moved by up to maxStep every frame, then time of finding started and ended pairs by sorting all pairs
+     * of every frame and merging them with sorted pairs of previous frame is compared to time of pair manager update
+     */
+    void testPairManager(QuadTree<T>* quadTree,
+                         int numberOfFrames,
+                         int numberOfElements,
+                         T maxStep = 2,
+                         int treeDepth = 6,
+                         int maxElementsPerBox = 6,
+                         const AABB<T> &boundingBox = AABB<T>(0,0,799,799),
+                         T minSize = 10,
+                         T maxSize = 50) const
+    {
+        typedef std::pair<ELEMENT_PTR,ELEMENT_PTR> PAIR;
+        std::string typeName = typeid(*quadTree).name();
+        std::cout<<"Performing pair manager test on '"<<typeName<<"' with "<<numberOfElements<<" elements for "<<numberOfFrames<<" frames..."<<std::endl;
+        QuadTreeDataGenerator<T> generator;
+        ELEMENTS_PTR elements = generator.makeElements(
+                    numberOfElements,
+                    boundingBox,
+                    minSize,
+                    maxSize);
+        long long overlappingPairs = 0;
+        long long sortedPairEvents = 0;
+        long long pairEvents = 0;
+        QuadTreePairManager<T> pairManager(
+                    [&](ELEMENT_PTR, ELEMENT_PTR){ pairEvents++; },
+                    [&](ELEMENT_PTR, ELEMENT_PTR){ pairEvents++; });
+        vector<PAIR> previousPairs, currentPairs;
+        std::chrono::high_resolution_clock::duration sortedPairsDuration(0), pairManagerDuration(0);
+        for(int i=0;i<numberOfFrames;i++){
+            for(auto element: elements){
+                element->aabb.translateBy(std::fmod(rand(),2*maxStep+1)-maxStep,std::fmod(rand(),2*maxStep+1)-maxStep);
+            }
+            quadTree->setElements(elements,boundingBox, treeDepth, maxElementsPerBox);
+            auto overlappingTuples = quadTree->getAllOverlappingElementTuples();
+            overlappingPairs += overlappingTuples.size();
+
+            std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+            currentPairs.clear();
+            for(auto &overlappingTuple: overlappingTuples){
+                ELEMENT_PTR element0 = std::get<0>(overlappingTuple);
+                ELEMENT_PTR element1 = std::get<1>(overlappingTuple);
+                currentPairs.push_back(element0 < element1 ? PAIR(element0,element1) : PAIR(element1,element0));
+            }
+            std::sort(currentPairs.begin(),currentPairs.end());
+            currentPairs.erase(std::unique(currentPairs.begin(),currentPairs.end()),currentPairs.end());
+            vector<PAIR> changedPairs;
+            std::set_symmetric_difference(previousPairs.begin(),previousPairs.end(),currentPairs.begin(),currentPairs.end(),std::back_inserter(changedPairs));
+            sortedPairEvents += changedPairs.size();
+            std::swap(previousPairs,currentPairs);
+            std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+            pairManager.update(overlappingTuples);
+            std::chrono::high_resolution_clock::time_point t3 = std::chrono::high_resolution_clock::now();
+            sortedPairsDuration += t2 - t1;
+            pairManagerDuration += t3 - t2;
+        }
+        auto sortedPairsMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(sortedPairsDuration).count();
+        auto pairManagerMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(pairManagerDuration).count();
+        std::cout<<"Average: "<<(double) overlappingPairs/numberOfFrames<<" pairs and "<<(double) pairEvents/numberOfFrames<<" begin/end events per frame"<<std::endl;
+        std::cout<<"Sorting and merging all pairs took "<<sortedPairsMicroseconds<<" microseconds, "<<sortedPairEvents<<" events"<<std::endl;
+        std::cout<<"Pair manager took "<<pairManagerMicroseconds<<" microseconds, "<<pairEvents<<" events"<<std::endl;
+    }
+
+    void printQuadTreeStats(const QuadTree<T>* quadTree) const{
+        QuadTreeStats stats = quadTree->getStats();
+        std::cout<<"   Nodes: "<<stats.nodesNumber<<
+                   ", leafs: "<<stats.leavesNumber<<
+                   ", element references: "<<stats.elementReferencesNumber<<
+                   ", leaf boxes: "<<stats.leafBoxesBytes<<" bytes";
+        if(stats.leafQuantizationBits > 0){
+            std::cout<<" (quantized to "<<stats.leafQuantizationBits<<" bits)";
+        }
+        std::cout<<std::endl;
+    }
+
     void printElementConstructionStats() const{
         std::cout<<"   Elements(): "<<QuadTreeElement<T>::countDefaultConstructor<<
                    ", Elements(args): "<<QuadTreeElement<T>::countConstructor<<
                    ", Elements(const &args): "<<QuadTreeElement<T>::countCopyConstructor<<
                    ", Elements(&&args): "<<QuadTreeElement<T>::countMoveConstructor<<std::endl;
     }
+
+protected:
+    static void startPerfCounters(QuadTreePerfCounters *perfCounters){
+        if(perfCounters != nullptr) perfCounters->start();
+    }
+    static void stopPerfCounters(QuadTreePerfCounters *perfCounters){
+        if(perfCounters != nullptr) perfCounters->stop();
+    }
+    static void printPerfCounters(const QuadTreePerfCounters *perfCounters, int numberOfTests, size_t numberOfElements){
+        if(perfCounters != nullptr) perfCounters->print((double) numberOfTests * std::max<size_t>(numberOfElements,1),"element");
+    }
+    static void translateElements(const ELEMENTS_PTR &elements, T shift){
+        for(auto element: elements){
+            element->aabb.translateBy(shift,shift);
+        }
+    }
+
+    bool usePerfCounters;
 };
 
 #endif // QUAD_TREE_BENCHMARK_H
@@ -0,0 +1,96 @@
+#ifndef QUAD_TREE_BRUTE_FORCE_H
+#define QUAD_TREE_BRUTE_FORCE_H
+
+#include "quad_tree.h"
+template <class T>
+class QuadTreeBruteForce;
+template <class T>
+class QuadTreeBruteForceVisualionHelper;
+
+/*
+ * Reference backend without any spatial structure: every pair of elements is tested.
+ * Meant as ground truth for other backends, each overlapping pair is returned exactly once
+ * and elements outside of bounding box are not dropped
+ */
+template <class T>
+class QuadTreeBruteForce: public QuadTree<T>{
+
+public:
+    typedef typename QuadTree<T>::ELEMENTS_PTR ELEMENTS_PTR;
+    typedef typename QuadTree<T>::ELEMENT_PTR ELEMENT_PTR;
+
+public:
+    QuadTreeBruteForce(){}
+    QuadTreeBruteForce(const ELEMENTS_PTR &inputElementsPtrs){
+        elementsPtrs = inputElementsPtrs;
+    }
+    virtual ~QuadTreeBruteForce(){}
+    // Note: only elements are used, boundingBox, depth and nodeCapacity are ignored
+    virtual void setElements(const ELEMENTS_PTR &inputElementsPtrs, const AABB<T> &/*boundingBox*/, int /*depth*/=6, int /*nodeCapacity*/=6) override{
+        elementsPtrs = inputElementsPtrs;
+    }
+    virtual ELEMENTS_PTR getElementsThatOverlap(const AABB<T> &aabb) const override{
+        ELEMENTS_PTR overlappingElementsPtrs;
+        for(auto elementPtr: elementsPtrs){
+            if(elementPtr->doesOverlap(aabb)){
+                overlappingElementsPtrs.push_back(elementPtr);
+            }
+        }
+        return overlappingElementsPtrs;
+    }
+    virtual ELEMENTS_PTR getAllOverlappingElements() const override{
+        vector<bool> isOverlapping(elementsPtrs.size(),false);
+        for(int i=0;i<elementsPtrs.size();i++){
+            for(int j=i+1;j<elementsPtrs.size();j++){
+                if(elementsPtrs.at(i)->doesOverlap(elementsPtrs.at(j)->aabb)){
+                    isOverlapping.at(i) = true;
+                    isOverlapping.at(j) = true;
+                }
+            }
+        }
+        ELEMENTS_PTR overlappingElementsPtrs;
+        for(int i=0;i<elementsPtrs.size();i++){
+            if(isOverlapping.at(i)) overlappingElementsPtrs.push_back(elementsPtrs.at(i));
+        }
+        return overlappingElementsPtrs;
+    }
+    virtual vector<tuple<ELEMENT_PTR,ELEMENT_PTR>> getAllOverlappingElementTuples() const override{
+        vector<tuple<ELEMENT_PTR,ELEMENT_PTR>> overlappingTuples;
+        for(int i=0;i<elementsPtrs.size();i++){
+            for(int j=i+1;j<elementsPtrs.size();j++){
+                if(elementsPtrs.at(i)->doesOverlap(elementsPtrs.at(j)->aabb)){
+                    overlappingTuples.push_back(tuple<ELEMENT_PTR,ELEMENT_PTR>(elementsPtrs.at(i),elementsPtrs.at(j)));
+                }
+            }
+        }
+        return overlappingTuples;
+    }
+    virtual void reset() override{
+        elementsPtrs.clear();
+    }
+    virtual const QuadTreeVisualionHelper<T> *getVisualisationHelper() const override{
+        return &visualisationHelper;
+    }
+    virtual QuadTreeStats getStats() const override{
+        QuadTreeStats stats;
+        stats.nodesNumber = 1;
+        stats.leavesNumber = 1;
+        stats.elementReferencesNumber = elementsPtrs.size();
+        stats.leafBoxesBytes = elementsPtrs.size() * sizeof(AABB<T>);
+        return stats;
+    }
+
+protected:
+    ELEMENTS_PTR elementsPtrs;
+    QuadTreeBruteForceVisualionHelper<T> visualisationHelper;
+};
+
+template <class T>
+class QuadTreeBruteForceVisualionHelper: public QuadTreeVisualionHelper<T>{
+public:
+    virtual vector<AABB<T>> getNonLeafNodesBoundingBoxes() const override{
+        return vector<AABB<T>>();
+    }
+};
+
+#endif // QUAD_TREE_BRUTE_FORCE_H
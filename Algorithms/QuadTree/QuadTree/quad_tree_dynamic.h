@@ -0,0 +1,413 @@
+#ifndef QUAD_TREE_DYNAMIC_H
+#define QUAD_TREE_DYNAMIC_H
+#include <unordered_map>
+#include <unordered_set>
+
+#include "quad_tree.h"
+template <class T>
+class DynamicAABBTree;
+template <class T>
+class DynamicAABBTreeVisualionHelper;
+
+template <class T>
+struct DynamicAABBTreeNode{
+    bool isLeaf() const{
+        return childrenId[0] == -1;
+    }
+    //Leafs keep fattened box of their element, other nodes keep union of children boxes
+    AABB<T> aabb;
+    int parentId = -1;
+    int nextFreeId = -1;
+    array<int,2> childrenId{{-1,-1}};
+    //Leaf has height 0, free node has height -1
+    int height = -1;
+    typename QuadTreeElement<T>::ELEMENT_PTR element = nullptr;
+};
+
+/*
+ * Bounding volume hierarchy for moving elements.
+ * Each element is owned by leaf (proxy) with box enlarged by fatMargin, so proxy has to be reinserted
+ * only when element leaves its fat box. Tree is kept balanced by AVL-like rotations.
+ * Pairs of proxies with overlapping fat boxes are cached and only moved proxies are queried again,
+ * exact overlap tests are done when pairs are requested.
+ * Nodes come from pool with free list so their ids stay valid until proxy is destroyed.
+ */
+template <class T>
+class DynamicAABBTree: public QuadTree<T>{
+
+public:
+    typedef typename QuadTree<T>::ELEMENTS_PTR ELEMENTS_PTR;
+    typedef typename QuadTree<T>::ELEMENT_PTR ELEMENT_PTR;
+    typedef std::unordered_set<ELEMENT_PTR> SET;
+
+    friend class DynamicAABBTreeVisualionHelper<T>;
+
+public:
+    DynamicAABBTree(T fatMargin=5):fatMargin(fatMargin){}
+    virtual ~DynamicAABBTree(){}
+    T getFatMargin() const{
+        return fatMargin;
+    }
+    /*
+     * Synchronizes tree with given elements: proxies are created for new elements, destroyed for missing ones
+     * and updated for the rest. Tree bounds aren't needed, so boundingBox, depth and nodeCapacity are ignored
+     */
+    virtual void setElements(const ELEMENTS_PTR &inputElementsPtrs, const AABB<T> &/*boundingBox*/, int /*depth*/=6, int /*nodeCapacity*/=6) override{
+        std::unordered_map<ELEMENT_PTR,int> updatedProxyIds;
+        updatedProxyIds.reserve(inputElementsPtrs.size());
+        for(auto element: inputElementsPtrs){
+            auto proxyIt = proxyIds.find(element);
+            if(proxyIt != proxyIds.end()){
+                updateProxy(proxyIt->second);
+                updatedProxyIds.insert(*proxyIt);
+                proxyIds.erase(proxyIt);
+            }else if(updatedProxyIds.count(element) == 0){
+                updatedProxyIds.insert(std::make_pair(element,insertProxy(element)));
+            }
+        }
+        for(auto &pair: proxyIds){
+            removeProxy(pair.second);
+        }
+        proxyIds = std::move(updatedProxyIds);
+        updatePairs();
+    }
+    virtual ELEMENTS_PTR getElementsThatOverlap(const AABB<T> &aabb) const override{
+        ELEMENTS_PTR overlappingElementsPtrs;
+        query(aabb,[&](int proxyId){
+            auto element = nodes.at(proxyId).element;
+            if(element->doesOverlap(aabb)){
+                overlappingElementsPtrs.push_back(element);
+            }
+        });
+        return overlappingElementsPtrs;
+    }
+    virtual ELEMENTS_PTR getAllOverlappingElements() const override{
+        SET elementSet;
+        for(auto &pair: proxyPairs){
+            auto element0 = nodes.at(pair.first).element;
+            auto element1 = nodes.at(pair.second).element;
+            if(element0->doesOverlap(element1->aabb)){
+                elementSet.insert(element0);
+                elementSet.insert(element1);
+            }
+        }
+        return ELEMENTS_PTR(elementSet.begin(),elementSet.end());
+    }
+    virtual vector<tuple<ELEMENT_PTR,ELEMENT_PTR>> getAllOverlappingElementTuples() const override{
+        vector<tuple<ELEMENT_PTR,ELEMENT_PTR>> overlappingTuples;
+        for(auto &pair: proxyPairs){
+            auto element0 = nodes.at(pair.first).element;
+            auto element1 = nodes.at(pair.second).element;
+            if(element0->doesOverlap(element1->aabb)){
+                overlappingTuples.push_back(tuple<ELEMENT_PTR,ELEMENT_PTR>(element0,element1));
+            }
+        }
+        return overlappingTuples;
+    }
+    virtual void reset() override{
+        nodes.clear();
+        proxyIds.clear();
+        proxyPairs.clear();
+        movedProxiesId.clear();
+        rootId = -1;
+        freeNodeId = -1;
+    }
+    virtual const QuadTreeVisualionHelper<T> *getVisualisationHelper() const override{
+        return &visualisationHelper;
+    }
+    virtual QuadTreeStats getStats() const override{
+        QuadTreeStats stats;
+        for(auto &node: nodes){
+            if(node.height == -1) continue;
+            stats.nodesNumber++;
+            if(node.isLeaf()){
+                stats.leavesNumber++;
+                stats.elementReferencesNumber++;
+                stats.leafBoxesBytes += sizeof(AABB<T>);
+            }
+        }
+        return stats;
+    }
+
+    //Per proxy API, updatePairs has to be called before pairs are requested
+    int insertProxy(ELEMENT_PTR element){
+        int proxyId = allocateNode();
+        DynamicAABBTreeNode<T> &node = nodes.at(proxyId);
+        node.aabb = fatten(element->aabb);
+        node.element = element;
+        node.height = 0;
+        insertLeaf(proxyId);
+        markMoved(proxyId);
+        return proxyId;
+    }
+    void removeProxy(int proxyId){
+        removeLeaf(proxyId);
+        freeNode(proxyId);
+        markMoved(proxyId);
+    }
+    //Returns true if element left its fat box and proxy was reinserted
+    bool updateProxy(int proxyId){
+        DynamicAABBTreeNode<T> &node = nodes.at(proxyId);
+        if(node.element->aabb.isCompletlyInside(node.aabb)){
+            return false;
+        }
+        removeLeaf(proxyId);
+        nodes.at(proxyId).aabb = fatten(nodes.at(proxyId).element->aabb);
+        insertLeaf(proxyId);
+        markMoved(proxyId);
+        return true;
+    }
+    //Pairs that don't involve moved proxies are kept, only moved proxies are queried against tree
+    void updatePairs(){
+        if(movedProxiesId.size() == 0) return;
+        vector<std::pair<int,int>> updatedProxyPairs;
+        updatedProxyPairs.reserve(proxyPairs.size());
+        for(auto &pair: proxyPairs){
+            if(!isMoved(pair.first) && !isMoved(pair.second)){
+                updatedProxyPairs.push_back(pair);
+            }
+        }
+        for(int movedProxyId: movedProxiesId){
+            const DynamicAABBTreeNode<T> &movedNode = nodes.at(movedProxyId);
+            if(movedNode.height != 0) continue;
+            query(movedNode.aabb,[&](int proxyId){
+                //Pair of moved proxies is added by the one with lower id
+                if(proxyId == movedProxyId || (isMoved(proxyId) && proxyId < movedProxyId)) return;
+                updatedProxyPairs.push_back(std::make_pair(std::min(proxyId,movedProxyId),std::max(proxyId,movedProxyId)));
+            });
+        }
+        for(int movedProxyId: movedProxiesId){
+            movedFlags.at(movedProxyId) = false;
+        }
+        movedProxiesId.clear();
+        proxyPairs = std::move(updatedProxyPairs);
+    }
+    int getHeight() const{
+        return rootId == -1 ? 0 : nodes.at(rootId).height;
+    }
+
+protected:
+    AABB<T> fatten(const AABB<T> &aabb) const{
+        return AABB<T>(aabb.xMin-fatMargin,aabb.yMin-fatMargin,aabb.xMax+fatMargin,aabb.yMax+fatMargin);
+    }
+    static AABB<T> merge(const AABB<T> &aabb0, const AABB<T> &aabb1){
+        return AABB<T>(std::min(aabb0.xMin,aabb1.xMin),std::min(aabb0.yMin,aabb1.yMin),
+                       std::max(aabb0.xMax,aabb1.xMax),std::max(aabb0.yMax,aabb1.yMax));
+    }
+    static double perimeter(const AABB<T> &aabb){
+        return 2.0*((double)aabb.xMax - aabb.xMin + (double)aabb.yMax - aabb.yMin);
+    }
+    void markMoved(int proxyId){
+        if(movedFlags.size() < nodes.size()){
+            movedFlags.resize(nodes.size(),false);
+        }
+        if(!movedFlags.at(proxyId)){
+            movedFlags.at(proxyId) = true;
+            movedProxiesId.push_back(proxyId);
+        }
+    }
+    bool isMoved(int proxyId) const{
+        return proxyId < movedFlags.size() && movedFlags.at(proxyId);
+    }
+    template <class VISITOR>
+    void query(const AABB<T> &aabb, VISITOR &&visitor) const{
+        if(rootId == -1) return;
+        vector<int> stack{rootId};
+        while(stack.size() > 0){
+            int nodeId = stack.back();
+            stack.pop_back();
+            const DynamicAABBTreeNode<T> &node = nodes.at(nodeId);
+            if(!node.aabb.doesOverlap(aabb)) continue;
+            if(node.isLeaf()){
+                visitor(nodeId);
+            }else{
+                stack.push_back(node.childrenId[0]);
+                stack.push_back(node.childrenId[1]);
+            }
+        }
+    }
+    int allocateNode(){
+        if(freeNodeId == -1){
+            nodes.push_back(DynamicAABBTreeNode<T>());
+            return nodes.size()-1;
+        }
+        int nodeId = freeNodeId;
+        freeNodeId = nodes.at(nodeId).nextFreeId;
+        nodes.at(nodeId) = DynamicAABBTreeNode<T>();
+        return nodeId;
+    }
+    void freeNode(int nodeId){
+        nodes.at(nodeId) = DynamicAABBTreeNode<T>();
+        nodes.at(nodeId).nextFreeId = freeNodeId;
+        freeNodeId = nodeId;
+    }
+    //Leaf becomes sibling of node that gives the smallest perimeter growth along the path
+    void insertLeaf(int leafId){
+        if(rootId == -1){
+            rootId = leafId;
+            nodes.at(leafId).parentId = -1;
+            return;
+        }
+        const AABB<T> leafAABB = nodes.at(leafId).aabb;
+        int siblingId = rootId;
+        while(!nodes.at(siblingId).isLeaf()){
+            const DynamicAABBTreeNode<T> &node = nodes.at(siblingId);
+            double nodePerimeter = perimeter(node.aabb);
+            double combinedPerimeter = perimeter(merge(node.aabb,leafAABB));
+            //Cost of making new parent for this node and the leaf
+            double cost = 2*combinedPerimeter;
+            //Minimum cost of pushing the leaf further down the tree
+            double inheritanceCost = 2*(combinedPerimeter - nodePerimeter);
+            array<double,2> childrenCost;
+            for(int i=0;i<2;i++){
+                const DynamicAABBTreeNode<T> &child = nodes.at(node.childrenId[i]);
+                childrenCost[i] = perimeter(merge(child.aabb,leafAABB)) + inheritanceCost;
+                if(!child.isLeaf()){
+                    childrenCost[i] -= perimeter(child.aabb);
+                }
+            }
+            if(cost < childrenCost[0] && cost < childrenCost[1]) break;
+            siblingId = childrenCost[0] < childrenCost[1] ? node.childrenId[0] : node.childrenId[1];
+        }
+
+        int oldParentId = nodes.at(siblingId).parentId;
+        int newParentId = allocateNode();
+        DynamicAABBTreeNode<T> &newParent = nodes.at(newParentId);
+        newParent.parentId = oldParentId;
+        newParent.aabb = merge(leafAABB,nodes.at(siblingId).aabb);
+        newParent.height = nodes.at(siblingId).height + 1;
+        newParent.childrenId = {{siblingId,leafId}};
+        if(oldParentId != -1){
+            replaceChild(oldParentId,siblingId,newParentId);
+        }else{
+            rootId = newParentId;
+        }
+        nodes.at(siblingId).parentId = newParentId;
+        nodes.at(leafId).parentId = newParentId;
+        refitAncestors(newParentId);
+    }
+    void removeLeaf(int leafId){
+        if(leafId == rootId){
+            rootId = -1;
+            return;
+        }
+        int parentId = nodes.at(leafId).parentId;
+        int grandParentId = nodes.at(parentId).parentId;
+        const array<int,2> &parentChildrenId = nodes.at(parentId).childrenId;
+        int siblingId = parentChildrenId[0] == leafId ? parentChildrenId[1] : parentChildrenId[0];
+        if(grandParentId != -1){
+            replaceChild(grandParentId,parentId,siblingId);
+            nodes.at(siblingId).parentId = grandParentId;
+            freeNode(parentId);
+            refitAncestors(grandParentId);
+        }else{
+            rootId = siblingId;
+            nodes.at(siblingId).parentId = -1;
+            freeNode(parentId);
+        }
+        nodes.at(leafId).parentId = -1;
+    }
+    void replaceChild(int parentId, int oldChildId, int newChildId){
+        array<int,2> &childrenId = nodes.at(parentId).childrenId;
+        if(childrenId[0] == oldChildId) childrenId[0] = newChildId;
+        else childrenId[1] = newChildId;
+    }
+    void refit(int nodeId){
+        DynamicAABBTreeNode<T> &node = nodes.at(nodeId);
+        const DynamicAABBTreeNode<T> &child0 = nodes.at(node.childrenId[0]);
+        const DynamicAABBTreeNode<T> &child1 = nodes.at(node.childrenId[1]);
+        node.aabb = merge(child0.aabb,child1.aabb);
+        node.height = 1 + std::max(child0.height,child1.height);
+    }
+    void refitAncestors(int nodeId){
+        while(nodeId != -1){
+            nodeId = balance(nodeId);
+            refit(nodeId);
+            nodeId = nodes.at(nodeId).parentId;
+        }
+    }
+    /*
+     * If subtrees of node A differ in height by more than one, higher child C is rotated up:
+     *        A              C
+     *      /   \          /   \
+     *     B     C   ->   A     F
+     *          / \      / \
+     *         F   G    B   G
+     * Higher grandchild (F here) stays with C. Returns id of node that took place of A
+     */
+    int balance(int nodeAId){
+        DynamicAABBTreeNode<T> &nodeA = nodes.at(nodeAId);
+        if(nodeA.isLeaf() || nodeA.height < 2){
+            return nodeAId;
+        }
+        int nodeBId = nodeA.childrenId[0];
+        int nodeCId = nodeA.childrenId[1];
+        int heightDifference = nodes.at(nodeCId).height - nodes.at(nodeBId).height;
+        if(heightDifference > 1){
+            return rotateUp(nodeAId,1);
+        }
+        if(heightDifference < -1){
+            return rotateUp(nodeAId,0);
+        }
+        return nodeAId;
+    }
+    //Child of A with given index takes A's place
+    int rotateUp(int nodeAId, int childIndex){
+        int nodeCId = nodes.at(nodeAId).childrenId[childIndex];
+        int nodeFId = nodes.at(nodeCId).childrenId[0];
+        int nodeGId = nodes.at(nodeCId).childrenId[1];
+        int parentId = nodes.at(nodeAId).parentId;
+
+        nodes.at(nodeCId).childrenId[0] = nodeAId;
+        nodes.at(nodeCId).parentId = parentId;
+        nodes.at(nodeAId).parentId = nodeCId;
+        if(parentId != -1){
+            replaceChild(parentId,nodeAId,nodeCId);
+        }else{
+            rootId = nodeCId;
+        }
+        //Higher grandchild stays with C, lower one replaces C under A
+        if(nodes.at(nodeFId).height < nodes.at(nodeGId).height){
+            std::swap(nodeFId,nodeGId);
+        }
+        nodes.at(nodeCId).childrenId[1] = nodeFId;
+        nodes.at(nodeAId).childrenId[childIndex] = nodeGId;
+        nodes.at(nodeGId).parentId = nodeAId;
+        refit(nodeAId);
+        refit(nodeCId);
+        return nodeCId;
+    }
+
+    T fatMargin;
+    vector<DynamicAABBTreeNode<T>> nodes;
+    int rootId = -1;
+    int freeNodeId = -1;
+    std::unordered_map<ELEMENT_PTR,int> proxyIds;
+    //Proxies whose fat boxes overlap, first id is always lower
+    vector<std::pair<int,int>> proxyPairs;
+    vector<int> movedProxiesId;
+    vector<bool> movedFlags;
+    DynamicAABBTreeVisualionHelper<T> visualisationHelper{this};
+};
+
+template <class T>
+class DynamicAABBTreeVisualionHelper: public QuadTreeVisualionHelper<T>{
+public:
+    DynamicAABBTreeVisualionHelper(DynamicAABBTree<T>* tree): tree(tree){}
+    virtual vector<AABB<T>> getNonLeafNodesBoundingBoxes() const override{
+        vector<AABB<T>> boundingBoxes;
+        for(auto &node: tree->nodes){
+            if(node.height > 0){
+                boundingBoxes.push_back(node.aabb);
+            }
+        }
+        return boundingBoxes;
+    }
+    virtual bool areNodesSplitAtCenter() const override{
+        return false;
+    }
+private:
+    DynamicAABBTree<T>* tree;
+};
+
+#endif // QUAD_TREE_DYNAMIC_H
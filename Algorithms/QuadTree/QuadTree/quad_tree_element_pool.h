@@ -0,0 +1,128 @@
+#ifndef QUAD_TREE_ELEMENT_POOL_H
+#define QUAD_TREE_ELEMENT_POOL_H
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+using std::vector;
+
+/*
+ * Typed slab allocator for elements. Elements are constructed in place inside chunks of CHUNK_SIZE slots,
+ * so elements made one after another are contiguous in memory. Destroyed slots are kept in free list
+ * and reused by next make. Pool owns all elements: reset (and destructor) destroys them and releases
+ * memory with one deallocation per chunk. Chunks are also indexed by address, so destroy finds owner
+ * of element with binary search
+ */
+template <class E, int CHUNK_SIZE = 1024>
+class QuadTreeElementPool{
+    static_assert(CHUNK_SIZE > 0, "Chunk must have at least one slot");
+
+protected:
+    typedef typename std::aligned_storage<sizeof(E),alignof(E)>::type Slot;
+    struct Chunk{
+        Slot storage[CHUNK_SIZE];
+        bool isAlive[CHUNK_SIZE];
+    };
+
+public:
+    QuadTreeElementPool(){}
+    ~QuadTreeElementPool(){
+        reset();
+    }
+    QuadTreeElementPool(const QuadTreeElementPool&) = delete;
+    QuadTreeElementPool &operator=(const QuadTreeElementPool&) = delete;
+
+    template <class... Args>
+    E* make(Args&&... args){
+        int chunkId, slotId;
+        if(!freeSlots.empty()){
+            chunkId = freeSlots.back().first;
+            slotId = freeSlots.back().second;
+            freeSlots.pop_back();
+        }else{
+            if(chunks.empty() || usedSlotsInLastChunk == CHUNK_SIZE){
+                chunks.push_back(std::unique_ptr<Chunk>(new Chunk));
+                std::fill(chunks.back()->isAlive,chunks.back()->isAlive + CHUNK_SIZE,false);
+                usedSlotsInLastChunk = 0;
+                auto chunkStart = std::make_pair(chunks.back()->storage,int(chunks.size() - 1));
+                chunksByAddress.insert(std::upper_bound(chunksByAddress.begin(),chunksByAddress.end(),chunkStart,isLowerAddress),chunkStart);
+            }
+            chunkId = chunks.size() - 1;
+            slotId = usedSlotsInLastChunk++;
+        }
+        Chunk &chunk = *chunks.at(chunkId);
+        E* element = new (&chunk.storage[slotId]) E(std::forward<Args>(args)...);
+        chunk.isAlive[slotId] = true;
+        elementsNumber++;
+        return element;
+    }
+    //Element must be made by this pool
+    void destroy(E* element){
+        Slot *slot = reinterpret_cast<Slot*>(element);
+        //Owner is the last chunk that starts at or before slot
+        auto chunkIt = std::upper_bound(chunksByAddress.begin(),chunksByAddress.end(),std::make_pair(slot,0),isLowerAddress);
+        if(chunkIt == chunksByAddress.begin()) return;
+        int chunkId = std::prev(chunkIt)->second;
+        Chunk &chunk = *chunks.at(chunkId);
+        if(!std::less<Slot*>()(slot,chunk.storage + CHUNK_SIZE)) return;
+        int slotId = slot - chunk.storage;
+        element->~E();
+        chunk.isAlive[slotId] = false;
+        freeSlots.push_back(std::make_pair(chunkId,slotId));
+        elementsNumber--;
+    }
+    void reset(){
+        if(!std::is_trivially_destructible<E>::value){
+            forEach([](E* element){ element->~E(); });
+        }
+        chunks.clear();
+        chunksByAddress.clear();
+        freeSlots.clear();
+        usedSlotsInLastChunk = 0;
+        elementsNumber = 0;
+    }
+    //Calls function for every alive element in memory order
+    template <class F>
+    void forEach(F function) const{
+        for(int chunkId=0;chunkId<chunks.size();chunkId++){
+            Chunk &chunk = *chunks.at(chunkId);
+            int slotsNumber = chunkId + 1 == chunks.size() ? usedSlotsInLastChunk : CHUNK_SIZE;
+            for(int slotId=0;slotId<slotsNumber;slotId++){
+                if(chunk.isAlive[slotId]) function(reinterpret_cast<E*>(&chunk.storage[slotId]));
+            }
+        }
+    }
+    //Alive elements in memory order
+    vector<E*> getElements() const{
+        vector<E*> elements;
+        elements.reserve(elementsNumber);
+        forEach([&elements](E* element){ elements.push_back(element); });
+        return elements;
+    }
+    int size() const{
+        return elementsNumber;
+    }
+    int getChunksNumber() const{
+        return chunks.size();
+    }
+
+protected:
+    static bool isLowerAddress(const std::pair<Slot*,int> &a, const std::pair<Slot*,int> &b){
+        return std::less<Slot*>()(a.first,b.first);
+    }
+
+    vector<std::unique_ptr<Chunk>> chunks;
+    //Start of storage and id of every chunk, sorted by address
+    vector<std::pair<Slot*,int>> chunksByAddress;
+    vector<std::pair<int,int>> freeSlots;
+    int usedSlotsInLastChunk = 0;
+    int elementsNumber = 0;
+};
+
+#endif // QUAD_TREE_ELEMENT_POOL_H
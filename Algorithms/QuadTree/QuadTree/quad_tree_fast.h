@@ -1,30 +1,27 @@
 #ifndef QUAD_TREE_FAST_H
 #define QUAD_TREE_FAST_H
 #include "quad_tree.h"
-#include <unordered_map>
-#include <set>
-#include <unordered_set>
-template <class T>
-class QuadTreeFast;
-template <class T>
-class QuadTreeFastVisualionHelper;
+#include "quad_tree_orthant.h"
 
 template <class T>
-struct QuadTreeFastNode{
-    QuadTreeFastNode(){
-        for(int i=0;i<4;i++){
-            childrenId.at(i) = -1;
+class QuadTreeFastVisualionHelper: public QuadTreeVisualionHelper<T>{
+public:
+    QuadTreeFastVisualionHelper(const OrthantTreeFastVisualionHelper<T,2,QuadTreeElement<T>>* helper): helper(helper){}
+    virtual vector<AABB<T>> getNonLeafNodesBoundingBoxes() const override{
+        vector<AABB<T>> boundingBoxes;
+        for(auto &boundingBox: helper->getNonLeafNodesBoundingBoxes()){
+            boundingBoxes.push_back(AABB<T>(boundingBox.min[0],boundingBox.min[1],boundingBox.max[0],boundingBox.max[1]));
         }
+        return boundingBoxes;
     }
-    bool isLeaf() const{
-        return  childrenId[0]==-1 && childrenId[1]==-1 &&
-                childrenId[2]==-1 && childrenId[3]==-1;
-    }
-    array<int,4> childrenId;
+private:
+    const OrthantTreeFastVisualionHelper<T,2,QuadTreeElement<T>>* helper;
 };
+
 /*
  * The main difference from moderate quad tree is the fact that elements are stored not only in leafs
- * but in ordinary node if given element overlaps node's bounding box completly
+ * but in ordinary node if given element overlaps node's bounding box completly.
+ * Tree itself is two dimensional OrthantTreeFast, this class only gives it QuadTree interface
  */
 template <class T>
 class QuadTreeFast: public QuadTree<T>{
@@ -33,206 +30,73 @@ public:
 
     typedef typename QuadTreeElement<T>::ELEMENT_PTR ELEMENT_PTR;
     typedef vector<ELEMENT_PTR> ELEMENTS_PTR;
-    typedef std::unordered_map<int,vector<int>> MAP;
-    typedef std::unordered_set<int> SET;
-
-    friend class QuadTreeFastVisualionHelper<T>;
+    typedef OrthantTreeFast<T,2,QuadTreeElement<T>> TREE;
 
 public:
     QuadTreeFast(){}
-    QuadTreeFast(const ELEMENTS_PTR &inputElementsPtrs, const AABB<T> &boundingBox, int depth=6, int nodeCapacity=6){
-        buildTree(inputElementsPtrs,boundingBox,depth,nodeCapacity);
-    }
+    QuadTreeFast(const ELEMENTS_PTR &inputElementsPtrs, const AABB<T> &boundingBox, int depth=6, int nodeCapacity=6):
+        tree(inputElementsPtrs,AABBN<T,2>(boundingBox),depth,nodeCapacity){}
     virtual ~QuadTreeFast(){}
-    virtual void setElements(const ELEMENTS_PTR &inputElementsPtrs, const AABB<T> &boundingBox, int depth=6, int nodeCapacity=6){
-        buildTree(inputElementsPtrs,boundingBox,depth,nodeCapacity);
+    virtual void setElements(const ELEMENTS_PTR &inputElementsPtrs, const AABB<T> &boundingBox, int depth=6, int nodeCapacity=6) override{
+        tree.setElements(inputElementsPtrs,AABBN<T,2>(boundingBox),depth,nodeCapacity);
     }
     virtual ELEMENTS_PTR getElementsThatOverlap(const AABB<T> &aabb) const override{
-        ELEMENTS_PTR placeHolder;
-        return placeHolder;
+        return tree.getElementsThatOverlap(aabb);
     }
     virtual ELEMENTS_PTR getAllOverlappingElements() const override{
-        SET elementIdSet;
-        getAllOverlappingElementsRecursively(elementIdSet,rootId);
-        ELEMENTS_PTR overlappingElementsPtrs(elementIdSet.size());
-        int i=0;
-        for(auto id: elementIdSet){
-            overlappingElementsPtrs.at(i) = elementsPtrs.at(id);
-            i++;
-        }
-
-        return overlappingElementsPtrs;
+        return tree.getAllOverlappingElements();
     }
     virtual vector<tuple<ELEMENT_PTR,ELEMENT_PTR>> getAllOverlappingElementTuples() const override{
+        return tree.getAllOverlappingElementTuples();
+    }
+    /*
+     * Pairs of overlapping elements where first element is from this tree and second is from other tree.
+     * If other tree is QuadTreeFast both trees are descended at once (see OrthantTreeFast::getOverlappingTuples),
+     * otherwise other tree is queried with every element. Each pair is returned once
+     */
+    vector<tuple<ELEMENT_PTR,ELEMENT_PTR>> getOverlappingTuples(const QuadTree<T> &other) const{
+        const QuadTreeFast<T> *otherFast = dynamic_cast<const QuadTreeFast<T>*>(&other);
+        if(otherFast != nullptr){
+            return tree.getOverlappingTuples(otherFast->tree);
+        }
         vector<tuple<ELEMENT_PTR,ELEMENT_PTR>> overlappingTuples;
-        getAllOverlappingElementTuplesRecursively(overlappingTuples,vector<int>(),rootId);
+        for(auto elementPtr: tree.getElements()){
+            for(auto otherElementPtr: other.getElementsThatOverlap(elementPtr->aabb)){
+                overlappingTuples.push_back(tuple<ELEMENT_PTR,ELEMENT_PTR>(elementPtr,otherElementPtr));
+            }
+        }
         return overlappingTuples;
     }
-    virtual void reset(){
-        nodes.clear();
-        elementsPtrs.clear();
-        nodeIdToElementId.clear();
-        boundingBoxes.clear();
-        rootId=-1;
-    }
-    virtual const QuadTreeVisualionHelper<T> *getVisualisationHelper() const override{
-        return &visualisationHelper;
+    //See OrthantTreeFast::setHilbertOrder
+    void setHilbertOrder(bool enabled, int threadsNumber = 1){
+        tree.setHilbertOrder(enabled,threadsNumber);
     }
-
-protected:
-    virtual void buildTree(const ELEMENTS_PTR &inputElementsPtrs,
-                           const AABB<T> &boundingBox,
-                           int depth,
-                           int nodeCapacity){
-        reset();
-        elementsPtrs = inputElementsPtrs;
-        vector<int> elementsId(inputElementsPtrs.size());
-        for(int i=0;i<inputElementsPtrs.size();i++){
-            elementsId.at(i) = i;
-        }
-        rootId = makeSubtree(inputElementsPtrs,elementsId,boundingBox,depth,nodeCapacity);
+    //See OrthantTreeFast::setPowerOfTwoSplit
+    void setPowerOfTwoSplit(bool enabled){
+        tree.setPowerOfTwoSplit(enabled);
     }
-    int makeSubtree(const ELEMENTS_PTR &elementsPtrs,
-                    vector<int> &elementsId,
-                    const AABB<T> &boundingBox,
-                    int levelRemaining,
-                    int nodeCapacity)
-    {
-        int rootId = nodes.size();
-        nodes.push_back(std::move(QuadTreeFastNode<T>()));
-        boundingBoxes.push_back(boundingBox);
-        if(elementsId.size() <= nodeCapacity || levelRemaining == 0){
-//            nodeIdToElementId[rootId] = elementsId;
-            nodeIdToElementId.insert(std::make_pair(rootId,std::move(elementsId)));
-        }else{
-            const array<AABB<T>,4> boundingBoxes = boundingBox.split();
-            auto pointsIdByQuadrant = splitElementsIdByQuadrant(elementsPtrs,elementsId,boundingBox,boundingBoxes);
-            elementsId.clear();
-//            nodeIdToElementId[rootId] = pointsIdByQuadrant.at(QUADRANT::CENTER);
-            nodeIdToElementId.insert(std::make_pair(rootId,std::move(pointsIdByQuadrant.at(QUADRANT::CENTER))));
-            for(int i=0;i<4;i++){
-                int childId = makeSubtree(elementsPtrs,pointsIdByQuadrant.at(i),boundingBoxes.at(i),levelRemaining-1,nodeCapacity);
-                nodes.at(rootId).childrenId.at(i) = childId;
-            }
-        }
-        return rootId;
+    const vector<int> &getElementsOrder() const{
+        return tree.getElementsOrder();
     }
-
-    array<vector<int>,5> splitElementsIdByQuadrant(const ELEMENTS_PTR &elementsPtrs, const vector<int> &elementsId, const AABB<T> &boundingBox,  const array<AABB<T>,4> &boundingBoxes) const{
-            array<vector<int>,5> elementsIdByQuadrant;
-            for(auto elementId: elementsId){
-                if(boundingBox.isCompletlyInside(elementsPtrs.at(elementId)->aabb)){
-                    elementsIdByQuadrant.at(QUADRANT::CENTER).push_back(elementId);
-                }else{
-                    for(int i=0;i<4;i++){
-                        if(elementsPtrs.at(elementId)->aabb.doesOverlap(boundingBoxes.at(i))){
-                            elementsIdByQuadrant.at(i).push_back(elementId);
-                        }
-                    }
-                }
-            }
-            return elementsIdByQuadrant;
+    virtual void reset() override{
+        tree.reset();
     }
-
-    void getAllOverlappingElementsRecursively(SET &elementSet, int nodeId) const{
-        if(nodeId != -1){
-            auto node = nodes.at(nodeId);
-            if(node.isLeaf()){
-                vector<int> elementsId = nodeIdToElementId.at(nodeId);
-                if(elementsId.size()>1){
-                    for(int i=0;i<elementsId.size();i++){
-                        for(int j=i+1;j<elementsId.size();j++){
-                            if(elementsPtrs.at(elementsId.at(i))->doesOverlap(elementsPtrs.at(elementsId.at(j))->aabb)){
-                                elementSet.insert(elementsId.at(i));
-                                elementSet.insert(elementsId.at(j));
-                            }
-                        }
-                    }
-                }
-            }else{
-                vector<int> elementsId = nodeIdToElementId.at(nodeId);
-                for(int i=0;i<elementsId.size();i++){
-                    elementSet.insert(elementsId.at(i));
-                }
-                for(int childId: node.childrenId){
-                    getAllOverlappingElementsRecursively(elementSet,childId);
-                }
-            }
-        }
+    virtual const QuadTreeVisualionHelper<T> *getVisualisationHelper() const override{
+        return &visualisationHelper;
     }
-
-    void getAllOverlappingElementTuplesRecursively(vector<tuple<ELEMENT_PTR,ELEMENT_PTR>> &tuples,const vector<int> &elementsIdUpperNode, int nodeId) const{
-        if(nodeId != -1){
-            auto node = nodes.at(nodeId);
-            if(node.isLeaf()){
-                vector<int> elementsId = nodeIdToElementId.at(nodeId);
-                if(elementsId.size()>1){
-                    for(int i=0;i<elementsId.size();i++){
-                        for(int j=i+1;j<elementsId.size();j++){
-                            if(elementsPtrs.at(elementsId.at(i))->doesOverlap(elementsPtrs.at(elementsId.at(j))->aabb)){
-                                tuples.push_back(tuple<ELEMENT_PTR,ELEMENT_PTR>(
-                                                     elementsPtrs.at(elementsId.at(i)),
-                                                     elementsPtrs.at(elementsId.at(j))));
-                            }
-                        }
-                    }
-                }
-                //all elementsIdUpperNode intersect entire bounding box and all elements of current node
-                for(int i=0;i<elementsId.size();i++){
-                    for(int j=0;j<elementsIdUpperNode.size();j++){
-                        tuples.push_back(tuple<ELEMENT_PTR,ELEMENT_PTR>(
-                                             elementsPtrs.at(elementsId.at(i)),
-                                             elementsPtrs.at(elementsIdUpperNode.at(j))));
-                    }
-                }
-            }else{
-                vector<int> elementsId = nodeIdToElementId.at(nodeId);
-                if(elementsId.size()>1){
-                    for(int i=0;i<elementsId.size();i++){
-                        for(int j=i+1;j<elementsId.size();j++){
-                            tuples.push_back(tuple<ELEMENT_PTR,ELEMENT_PTR>(elementsPtrs.at(elementsId.at(i)),elementsPtrs.at(elementsId.at(j))));
-                        }
-                    }
-                }
-                elementsId.insert(elementsId.end(),elementsIdUpperNode.begin(),elementsIdUpperNode.end());
-                for(int childId: node.childrenId){
-                    getAllOverlappingElementTuplesRecursively(tuples,elementsId,childId);
-                }
-            }
-        }
+    virtual QuadTreeQueryStats getQueryStats() const override{
+        return tree.getQueryStats();
     }
-
-    vector<QuadTreeFastNode<T>> nodes;
-    vector<AABB<T>> boundingBoxes;
-    ELEMENTS_PTR elementsPtrs;
-    MAP nodeIdToElementId;
-    int rootId=-1;
-    QuadTreeFastVisualionHelper<T> visualisationHelper{this};
-
-};
-
-template <class T>
-class QuadTreeFastVisualionHelper: public QuadTreeVisualionHelper<T>{
-public:
-    QuadTreeFastVisualionHelper(QuadTreeFast<T>* quadTree): quadTree(quadTree){}
-    virtual vector<AABB<T>> getNonLeafNodesBoundingBoxes() const override{
-        vector<AABB<T>> boundingBoxes;
-        getNonLeafNodesBoundingBoxesRecursivly(boundingBoxes,quadTree->rootId);
-        return boundingBoxes;
+    virtual void resetQueryStats() override{
+        tree.resetQueryStats();
     }
-private:
-    QuadTreeFast<T>* quadTree;
-    void getNonLeafNodesBoundingBoxesRecursivly(vector<AABB<T>> &boundingBoxes, int nodeId) const{
-        if(nodeId != -1){
-            auto node = quadTree->nodes.at(nodeId);
-            if(!node.isLeaf()){
-                boundingBoxes.push_back(quadTree->boundingBoxes.at(nodeId));
-                for(int childId: node.childrenId){
-                    getNonLeafNodesBoundingBoxesRecursivly(boundingBoxes,childId);
-                }
-            }
-        }
+    virtual QuadTreeStats getStats() const override{
+        return tree.getStats();
     }
+
+protected:
+    TREE tree;
+    QuadTreeFastVisualionHelper<T> visualisationHelper{tree.getVisualisationHelper()};
 };
 
 #endif // QUAD_TREE_FAST_H
@@ -1,5 +1,6 @@
 #ifndef QUAD_TREE_MODERATE_H
 #define QUAD_TREE_MODERATE_H
+#include <mutex>
 #include <unordered_map>
 #include <set>
 #include <unordered_set>
@@ -35,6 +36,8 @@ public:
     typedef std::unordered_map<int,vector<int>> MAP;
     typedef std::unordered_set<int> SET;
 
+    static const bool queryCounters = QUAD_TREE_QUERY_COUNTERS;
+
     friend class QuadTreeModerateVisualionHelper<T>;
 
 public:
@@ -47,11 +50,20 @@ public:
         buildTree(inputElementsPtrs,boundingBox,depth,nodeCapacity);
     }
     virtual ELEMENTS_PTR getElementsThatOverlap(const AABB<T> &aabb) const override{
-        ELEMENTS_PTR placeHolder;
-        return placeHolder;}
+        SET elementIdSet;
+        getElementsThatOverlapRecursively(elementIdSet,aabb,rootId);
+        ELEMENTS_PTR overlappingElementsPtrs;
+        overlappingElementsPtrs.reserve(elementIdSet.size());
+        for(auto id: elementIdSet){
+            overlappingElementsPtrs.push_back(elementsPtrs.at(id));
+        }
+        return overlappingElementsPtrs;
+    }
     virtual ELEMENTS_PTR getAllOverlappingElements() const override{
         SET elementIdSet;
-        getAllOverlappingElementsRecursively(elementIdSet,rootId);
+        QuadTreeQueryStats stats;
+        getAllOverlappingElementsRecursively(elementIdSet,rootId,stats);
+        addQueryStats(stats);
         ELEMENTS_PTR overlappingElementsPtrs(elementIdSet.size());
         int i=0;
         for(auto id: elementIdSet){
@@ -63,7 +75,9 @@ public:
     }
     virtual vector<tuple<ELEMENT_PTR,ELEMENT_PTR>> getAllOverlappingElementTuples() const override{
         vector<tuple<ELEMENT_PTR,ELEMENT_PTR>> overlappingTuples;
-        getAllOverlappingElementTuplesRecursively(overlappingTuples,rootId);
+        QuadTreeQueryStats stats;
+        getAllOverlappingElementTuplesRecursively(overlappingTuples,rootId,stats);
+        addQueryStats(stats);
         return overlappingTuples;
     }
     virtual void reset(){
@@ -76,6 +90,24 @@ public:
     virtual const QuadTreeVisualionHelper<T> *getVisualisationHelper() const override{
         return &visualisationHelper;
     }
+    virtual QuadTreeStats getStats() const override{
+        QuadTreeStats stats;
+        stats.nodesNumber = nodes.size();
+        for(auto &pair: nodeIdToElementId){
+            stats.leavesNumber++;
+            stats.elementReferencesNumber += pair.second.size();
+            stats.leafBoxesBytes += pair.second.size() * sizeof(AABB<T>);
+        }
+        return stats;
+    }
+    virtual QuadTreeQueryStats getQueryStats() const override{
+        std::lock_guard<std::mutex> lock(queryStatsMutex);
+        return queryStats;
+    }
+    virtual void resetQueryStats() override{
+        std::lock_guard<std::mutex> lock(queryStatsMutex);
+        queryStats = QuadTreeQueryStats();
+    }
 
 protected:
     virtual void buildTree(const ELEMENTS_PTR &inputElementsPtrs,
@@ -125,15 +157,35 @@ protected:
             return elementsIdByQuadrant;
     }
 
-    void getAllOverlappingElementTuplesRecursively(vector<tuple<ELEMENT_PTR,ELEMENT_PTR>> &tuples, int nodeId) const{
+    void getElementsThatOverlapRecursively(SET &elementSet, const AABB<T> &aabb, int nodeId) const{
+        if(nodeId == -1 || !boundingBoxes.at(nodeId).doesOverlap(aabb)) return;
+        const auto &node = nodes.at(nodeId);
+        if(node.isLeaf()){
+            for(auto elementId: nodeIdToElementId.at(nodeId)){
+                if(elementsPtrs.at(elementId)->doesOverlap(aabb)){
+                    elementSet.insert(elementId);
+                }
+            }
+        }else{
+            for(int childId: node.childrenId){
+                getElementsThatOverlapRecursively(elementSet,aabb,childId);
+            }
+        }
+    }
+
+    void getAllOverlappingElementTuplesRecursively(vector<tuple<ELEMENT_PTR,ELEMENT_PTR>> &tuples, int nodeId, QuadTreeQueryStats &stats) const{
         if(nodeId != -1){
             auto node = nodes.at(nodeId);
+            if(queryCounters) stats.nodesVisited++;
             if(node.isLeaf()){
+                if(queryCounters) stats.leavesVisited++;
                 vector<int> elementsId = nodeIdToElementId.at(nodeId);
                 if(elementsId.size()>1){
                     for(int i=0;i<elementsId.size();i++){
                         for(int j=i+1;j<elementsId.size();j++){
+                            if(queryCounters) stats.candidatePairs++;
                             if(elementsPtrs.at(elementsId.at(i))->doesOverlap(elementsPtrs.at(elementsId.at(j))->aabb)){
+                                if(queryCounters) stats.emittedPairs++;
                                 tuples.push_back(tuple<ELEMENT_PTR,ELEMENT_PTR>(elementsPtrs.at(elementsId.at(i)),elementsPtrs.at(elementsId.at(j))));
                             }
                         }
@@ -141,21 +193,25 @@ protected:
                 }
             }else{
                 for(int childId: node.childrenId){
-                    getAllOverlappingElementTuplesRecursively(tuples,childId);
+                    getAllOverlappingElementTuplesRecursively(tuples,childId,stats);
                 }
             }
         }
     }
 
-    void getAllOverlappingElementsRecursively(SET &elementSet, int nodeId) const{
+    void getAllOverlappingElementsRecursively(SET &elementSet, int nodeId, QuadTreeQueryStats &stats) const{
         if(nodeId != -1){
             auto node = nodes.at(nodeId);
+            if(queryCounters) stats.nodesVisited++;
             if(node.isLeaf()){
+                if(queryCounters) stats.leavesVisited++;
                 vector<int> elementsId = nodeIdToElementId.at(nodeId);
                 if(elementsId.size()>1){
                     for(int i=0;i<elementsId.size();i++){
                         for(int j=i+1;j<elementsId.size();j++){
+                            if(queryCounters) stats.candidatePairs++;
                             if(elementsPtrs.at(elementsId.at(i))->doesOverlap(elementsPtrs.at(elementsId.at(j))->aabb)){
+                                if(queryCounters) stats.emittedPairs++;
                                 elementSet.insert(elementsId.at(i));
                                 elementSet.insert(elementsId.at(j));
                             }
@@ -164,16 +220,25 @@ protected:
                 }
             }else{
                 for(int childId: node.childrenId){
-                    getAllOverlappingElementsRecursively(elementSet,childId);
+                    getAllOverlappingElementsRecursively(elementSet,childId,stats);
                 }
             }
         }
     }
+    void addQueryStats(const QuadTreeQueryStats &stats) const{
+        if(!queryCounters) return;
+        std::lock_guard<std::mutex> lock(queryStatsMutex);
+        queryStats.add(stats);
+    }
+
     vector<QuadTreeModerateNode<T>> nodes;
     vector<AABB<T>> boundingBoxes;
     ELEMENTS_PTR elementsPtrs;
     MAP nodeIdToElementId;
     int rootId=-1;
+    //Sum of stats of finished queries
+    mutable QuadTreeQueryStats queryStats;
+    mutable std::mutex queryStatsMutex;
     QuadTreeModerateVisualionHelper<T> visualisationHelper{this};
 };
 
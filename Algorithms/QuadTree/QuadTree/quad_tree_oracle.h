@@ -0,0 +1,169 @@
+#ifndef QUAD_TREE_ORACLE_H
+#define QUAD_TREE_ORACLE_H
+#include <chrono>
+#include <random>
+#include <string>
+#include <utility>
+
+#include "quad_tree.h"
+#include "quad_tree_brute_force.h"
+
+enum QUAD_TREE_ORACLE_SCENE_TYPE{UNIFORM,CLUSTERED,GRID};
+
+//Generated scene, all elements are completly inside boundingBox
+template <class T>
+struct QuadTreeOracleScene{
+    QUAD_TREE_ORACLE_SCENE_TYPE type;
+    int numberOfElements;
+    AABB<T> boundingBox;
+    T minSize;
+    T maxSize;
+    int treeDepth;
+    int maxElementsPerBox;
+};
+
+/*
+ * Differential test of QuadTree<T> backends against QuadTreeBruteForce.
+ * Pairs returned by every backend are canonicalized (lower pointer first, sorted, without duplicates)
+ * and compared with brute force pairs. Time of setElements plus getAllOverlappingElementTuples is reported
+ * as ratio to brute force time.
+ */
+template <class T>
+class QuadTreeOracle{
+public:
+    typedef typename QuadTree<T>::ELEMENTS_PTR ELEMENTS_PTR;
+    typedef typename QuadTree<T>::ELEMENT_PTR ELEMENT_PTR;
+    typedef std::pair<ELEMENT_PTR,ELEMENT_PTR> PAIR;
+    typedef std::pair<std::string,QuadTree<T>*> NAMED_QUAD_TREE;
+
+public:
+    QuadTreeOracle(unsigned int seed):randomEngine(seed){}
+    //Returns number of backend runs that didn't match brute force
+    int run(const vector<NAMED_QUAD_TREE> &quadTrees, const vector<QuadTreeOracleScene<T>> &scenes, int numberOfRepetitions) {
+        int mismatchesNumber = 0;
+        for(auto &scene: scenes){
+            vector<QuadTreeElement<T>> elements = makeElements(scene);
+            ELEMENTS_PTR elementsPtrs;
+            for(auto &element: elements){
+                elementsPtrs.push_back(&element);
+            }
+            std::cout<<"Scene "<<getSceneTypeName(scene.type)<<" with "<<elementsPtrs.size()<<" elements, depth "<<scene.treeDepth<<", capacity "<<scene.maxElementsPerBox<<std::endl;
+
+            QuadTreeBruteForce<T> bruteForce;
+            vector<PAIR> expectedPairs;
+            double bruteForceMilliseconds = measure(bruteForce,elementsPtrs,scene,numberOfRepetitions,expectedPairs);
+            std::cout<<"   brute force: "<<expectedPairs.size()<<" pairs, "<<bruteForceMilliseconds<<" ms"<<std::endl;
+
+            for(auto &namedQuadTree: quadTrees){
+                vector<PAIR> pairs;
+                size_t tuplesNumber = 0;
+                double milliseconds = measure(*namedQuadTree.second,elementsPtrs,scene,numberOfRepetitions,pairs,&tuplesNumber);
+                bool matches = pairs == expectedPairs;
+                std::cout<<"   "<<(matches ? "OK       " : "MISMATCH ")<<namedQuadTree.first<<": "<<
+                           pairs.size()<<" pairs ("<<tuplesNumber - pairs.size()<<" duplicates), "<<
+                           milliseconds<<" ms, ratio to brute force "<<milliseconds/std::max(bruteForceMilliseconds,1e-6)<<std::endl;
+                if(!matches){
+                    mismatchesNumber++;
+                    printDifference(expectedPairs,pairs);
+                }
+            }
+        }
+        return mismatchesNumber;
+    }
+
+protected:
+    //Average time of single setElements plus getAllOverlappingElementTuples, canonical pairs of the last run are stored in pairs
+    double measure(QuadTree<T> &quadTree, const ELEMENTS_PTR &elementsPtrs, const QuadTreeOracleScene<T> &scene,
+                   int numberOfRepetitions, vector<PAIR> &pairs, size_t *tuplesNumber = nullptr) const{
+        vector<tuple<ELEMENT_PTR,ELEMENT_PTR>> tuples;
+        std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+        for(int i=0;i<numberOfRepetitions;i++){
+            quadTree.setElements(elementsPtrs,scene.boundingBox,scene.treeDepth,scene.maxElementsPerBox);
+            tuples = quadTree.getAllOverlappingElementTuples();
+        }
+        std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+        if(tuplesNumber != nullptr) *tuplesNumber = tuples.size();
+        pairs = canonicalize(tuples);
+        quadTree.reset();
+        return std::chrono::duration<double,std::milli>(t2 - t1).count() / std::max(numberOfRepetitions,1);
+    }
+    static vector<PAIR> canonicalize(const vector<tuple<ELEMENT_PTR,ELEMENT_PTR>> &tuples){
+        vector<PAIR> pairs;
+        pairs.reserve(tuples.size());
+        for(auto &tuple: tuples){
+            ELEMENT_PTR element0 = std::get<0>(tuple);
+            ELEMENT_PTR element1 = std::get<1>(tuple);
+            if(std::less<ELEMENT_PTR>()(element1,element0)) std::swap(element0,element1);
+            pairs.push_back(PAIR(element0,element1));
+        }
+        std::sort(pairs.begin(),pairs.end());
+        pairs.erase(std::unique(pairs.begin(),pairs.end()),pairs.end());
+        return pairs;
+    }
+    static void printDifference(const vector<PAIR> &expectedPairs, const vector<PAIR> &pairs){
+        vector<PAIR> missingPairs, extraPairs;
+        std::set_difference(expectedPairs.begin(),expectedPairs.end(),pairs.begin(),pairs.end(),std::back_inserter(missingPairs));
+        std::set_difference(pairs.begin(),pairs.end(),expectedPairs.begin(),expectedPairs.end(),std::back_inserter(extraPairs));
+        std::cout<<"      missing "<<missingPairs.size()<<", extra "<<extraPairs.size()<<std::endl;
+        if(!missingPairs.empty()){
+            std::cout<<"      first missing pair:"<<std::endl<<"      ";
+            missingPairs.front().first->aabb.print();
+            std::cout<<"      ";
+            missingPairs.front().second->aabb.print();
+        }
+    }
+
+    vector<QuadTreeElement<T>> makeElements(const QuadTreeOracleScene<T> &scene){
+        vector<QuadTreeElement<T>> elements;
+        elements.reserve(scene.numberOfElements);
+        const AABB<T> &boundingBox = scene.boundingBox;
+        if(scene.type == QUAD_TREE_ORACLE_SCENE_TYPE::GRID){
+            //Boxes of maxSize side touching each other and every second row shifted by half of the side
+            int columns = std::max(1,static_cast<int>((boundingBox.xMax - boundingBox.xMin) / scene.maxSize) - 1);
+            for(int i=0;i<scene.numberOfElements;i++){
+                int row = i / columns;
+                int column = i % columns;
+                T x = boundingBox.xMin + column * scene.maxSize + (row % 2) * (scene.maxSize / 2);
+                T y = boundingBox.yMin + row * scene.maxSize / 2;
+                if(y + scene.maxSize > boundingBox.yMax) break;
+                elements.push_back(QuadTreeElement<T>(AABB<T>(x,y,x+scene.maxSize,y+scene.maxSize)));
+            }
+            return elements;
+        }
+        AABB<T> spawnBox = boundingBox;
+        if(scene.type == QUAD_TREE_ORACLE_SCENE_TYPE::CLUSTERED){
+            //All elements in the small corner of the root, so tree reaches its maximum depth there
+            spawnBox.xMax = boundingBox.xMin + (boundingBox.xMax - boundingBox.xMin) / 8 + scene.maxSize;
+            spawnBox.yMax = boundingBox.yMin + (boundingBox.yMax - boundingBox.yMin) / 8 + scene.maxSize;
+        }
+        for(int i=0;i<scene.numberOfElements;i++){
+            T width = getRandom(scene.minSize,scene.maxSize);
+            T height = getRandom(scene.minSize,scene.maxSize);
+            T x = getRandom(spawnBox.xMin,spawnBox.xMax - width);
+            T y = getRandom(spawnBox.yMin,spawnBox.yMax - height);
+            elements.push_back(QuadTreeElement<T>(AABB<T>(x,y,x+width,y+height)));
+        }
+        return elements;
+    }
+    T getRandom(T min, T max){
+        return getRandom(min,max,std::is_integral<T>());
+    }
+    T getRandom(T min, T max, std::true_type){
+        return std::uniform_int_distribution<T>(min,max)(randomEngine);
+    }
+    T getRandom(T min, T max, std::false_type){
+        return std::uniform_real_distribution<T>(min,max)(randomEngine);
+    }
+    static std::string getSceneTypeName(QUAD_TREE_ORACLE_SCENE_TYPE type){
+        switch(type){
+        case QUAD_TREE_ORACLE_SCENE_TYPE::UNIFORM: return "uniform";
+        case QUAD_TREE_ORACLE_SCENE_TYPE::CLUSTERED: return "clustered";
+        case QUAD_TREE_ORACLE_SCENE_TYPE::GRID: return "grid";
+        }
+        return "";
+    }
+
+    std::mt19937 randomEngine;
+};
+
+#endif // QUAD_TREE_ORACLE_H
@@ -0,0 +1,801 @@
+#ifndef QUAD_TREE_ORTHANT_H
+#define QUAD_TREE_ORTHANT_H
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "quad_tree.h"
+#include "quad_tree_parallel.h"
+
+template <class T, int D>
+struct OrthantTreeElement;
+template <class T, int D, class ELEMENT = OrthantTreeElement<T,D>>
+class OrthantTreeFast;
+template <class T, int D, class ELEMENT>
+class OrthantTreeFastVisualionHelper;
+
+//Calls function(I) for I in [FIRST,LAST), unrolled at compile time
+template <int FIRST, int LAST>
+struct StaticFor{
+    template <class FUNCTION>
+    static void apply(FUNCTION &&function){
+        function(FIRST);
+        StaticFor<FIRST+1,LAST>::apply(function);
+    }
+    //True if predicate(I) is true for all I, stops at first false
+    template <class PREDICATE>
+    static bool all(PREDICATE &&predicate){
+        return predicate(FIRST) && StaticFor<FIRST+1,LAST>::all(predicate);
+    }
+};
+template <int LAST>
+struct StaticFor<LAST,LAST>{
+    template <class FUNCTION>
+    static void apply(FUNCTION &&){}
+    template <class PREDICATE>
+    static bool all(PREDICATE &&){
+        return true;
+    }
+};
+
+//Axis aligned bounding box in D dimensions
+template <class T, int D, typename std::enable_if<std::is_arithmetic<T>::value>::type* = nullptr>
+struct AABBN{
+    static const int CHILDREN_NUMBER = 1 << D;
+
+    AABBN(){
+        min.fill(0);
+        max.fill(0);
+    }
+    AABBN(const array<T,D> &min, const array<T,D> &max):min(min),max(max){}
+    explicit AABBN(const AABB<T> &aabb){
+        static_assert(D == 2, "Only 2D box can be made from AABB");
+        min = {aabb.xMin,aabb.yMin};
+        max = {aabb.xMax,aabb.yMax};
+    }
+    array<T,D> min,max;
+    bool doesOverlap(const AABBN &another)const{
+        return StaticFor<0,D>::all([&](int i){
+            return this->max[i] > another.min[i] && another.max[i] > this->min[i];
+        });
+    }
+    // Note: object is always inside itself for your purposes
+    bool isCompletlyInside(const AABBN &another)const{
+        return StaticFor<0,D>::all([&](int i){
+            return min[i] >= another.min[i] && max[i] <= another.max[i];
+        });
+    }
+    /*
+     * Bit (D-1-i) of child index is set if child lies in lower half of dimension i,
+     * so for D=2 children come in QUADRANT order
+     */
+    array<AABBN,CHILDREN_NUMBER> split() const{
+        array<T,D> center;
+        StaticFor<0,D>::apply([&](int i){
+            center[i] = min[i]+(max[i] - min[i])/2;
+        });
+        array<AABBN,CHILDREN_NUMBER> children;
+        for(int childId=0;childId<CHILDREN_NUMBER;childId++){
+            StaticFor<0,D>::apply([&](int i){
+                bool lower = (childId >> (D-1-i)) & 1;
+                children[childId].min[i] = lower ? min[i] : center[i];
+                children[childId].max[i] = lower ? center[i] : max[i];
+            });
+        }
+        return children;
+    }
+    //Same as split for integral T and box with power of two sides, center is found with shifts
+    array<AABBN,CHILDREN_NUMBER> splitPowerOfTwo() const{
+        static_assert(std::is_integral<T>::value, "splitPowerOfTwo requires integral coordinates");
+        array<T,D> center;
+        StaticFor<0,D>::apply([&](int i){
+            center[i] = min[i]+((max[i] - min[i]) >> 1);
+        });
+        array<AABBN,CHILDREN_NUMBER> children;
+        for(int childId=0;childId<CHILDREN_NUMBER;childId++){
+            StaticFor<0,D>::apply([&](int i){
+                bool lower = (childId >> (D-1-i)) & 1;
+                children[childId].min[i] = lower ? min[i] : center[i];
+                children[childId].max[i] = lower ? center[i] : max[i];
+            });
+        }
+        return children;
+    }
+    void translateBy(const array<T,D> &delta){
+        StaticFor<0,D>::apply([&](int i){
+            min[i]+=delta[i];
+            max[i]+=delta[i];
+        });
+    }
+    bool operator ==(const AABBN &other) const{
+        return min == other.min && max == other.max;
+    }
+    void print(){
+        for(int i=0;i<D;i++){
+            std::cout<<"min["<<i<<"] = "<<min[i]<<" max["<<i<<"] = "<<max[i]<<" ";
+        }
+        std::cout<<std::endl;
+    }
+};
+
+//Inherit this class for object to be used with orthant tree
+template <class T, int D>
+struct OrthantTreeElement{
+
+    typedef OrthantTreeElement<T,D>* ELEMENT_PTR;
+    typedef OrthantTreeElement<T,D>* Type;
+
+    OrthantTreeElement(){}
+    OrthantTreeElement(const AABBN<T,D> &aabb):aabb(aabb){}
+    virtual ~OrthantTreeElement(){}
+    virtual bool doesOverlap(const AABBN<T,D> &another)const{
+        return aabb.doesOverlap(another);
+    }
+    static ELEMENT_PTR makeElement(const AABBN<T,D> &aabb)
+    {
+      return new OrthantTreeElement<T,D>(aabb);
+    }
+    AABBN<T,D> aabb;
+};
+
+
+//Box of D dimensions stored as offsets relative to reference box with Q precision, rounded outward like QuantizedAABB
+template <class Q, int D>
+struct QuantizedAABBN{
+    QuantizedAABBN(){
+        min.fill(0);
+        max.fill(0);
+    }
+    template <class T>
+    QuantizedAABBN(const AABBN<T,D> &aabb, const AABBN<T,D> &referenceBox){
+        StaticFor<0,D>::apply([&](int i){
+            min[i] = QuantizedAABB<Q>::quantizeDown(aabb.min[i],referenceBox.min[i],referenceBox.max[i]);
+            max[i] = QuantizedAABB<Q>::quantizeUp(aabb.max[i],referenceBox.min[i],referenceBox.max[i]);
+        });
+    }
+    array<Q,D> min,max;
+    // Note: touching boxes are considered overlapping to stay conservative after rounding
+    bool mayOverlap(const QuantizedAABBN &another)const{
+        return StaticFor<0,D>::all([&](int i){
+            return this->max[i] >= another.min[i] && another.max[i] >= this->min[i];
+        });
+    }
+};
+
+//Boxes of elements are read as AABBN, so elements with AABB boxes can be stored in two dimensional orthant tree
+template <class T, int D>
+const AABBN<T,D> &toAABBN(const AABBN<T,D> &aabb){
+    return aabb;
+}
+template <class T>
+AABBN<T,2> toAABBN(const AABB<T> &aabb){
+    return AABBN<T,2>(aabb);
+}
+
+template <class T, int D>
+struct OrthantTreeFastNode{
+    OrthantTreeFastNode(){
+        childrenId.fill(-1);
+    }
+    //Children are always created all at once
+    bool isLeaf() const{
+        return childrenId[0]==-1;
+    }
+    array<int,AABBN<T,D>::CHILDREN_NUMBER> childrenId;
+    //Range of OrthantTreeFast::leafElements that belongs to leaf
+    int leafElementsBegin=0;
+    int leafElementsEnd=0;
+};
+
+/*
+ * Tree where each node has 2^D children and elements are stored not only in leafs
+ * but in ordinary node if given element overlaps node's bounding box completly.
+ * D=2 is quad tree (QuadTreeFast is its QuadTree interface), D=3 is octree.
+ * ELEMENT must have aabb member that is either AABBN<T,D> or AABB<T> for D=2 and doesOverlap taking that box
+ */
+template <class T, int D, class ELEMENT>
+class OrthantTreeFast{
+
+public:
+
+    typedef ELEMENT* ELEMENT_PTR;
+    typedef vector<ELEMENT_PTR> ELEMENTS_PTR;
+    typedef decltype(ELEMENT::aabb) ELEMENT_BOX;
+    typedef AABBN<T,D> BOX;
+    typedef std::unordered_map<int,vector<int>> MAP;
+    typedef std::unordered_set<int> SET;
+    static const int CHILDREN_NUMBER = BOX::CHILDREN_NUMBER;
+
+    static const int leafQuantizationBits = QUAD_TREE_LEAF_QUANTIZATION_BITS;
+    static_assert(leafQuantizationBits == 0 || leafQuantizationBits == 8 || leafQuantizationBits == 16,
+                  "QUAD_TREE_LEAF_QUANTIZATION_BITS must be 0, 8 or 16");
+    typedef QuantizedAABBN<typename std::conditional<leafQuantizationBits == 16, uint16_t, uint8_t>::type,D> QUANTIZED_BOX;
+    typedef typename std::conditional<leafQuantizationBits == 0, BOX, QUANTIZED_BOX>::type LEAF_BOX;
+    //Elements of leaf are kept next to their boxes, so pairs inside leaf are tested on contiguous memory
+    struct LeafElement{
+        LEAF_BOX aabb;
+        int elementId;
+    };
+    static const bool queryCounters = QUAD_TREE_QUERY_COUNTERS;
+
+    friend class OrthantTreeFastVisualionHelper<T,D,ELEMENT>;
+
+public:
+    OrthantTreeFast(){}
+    OrthantTreeFast(const ELEMENTS_PTR &inputElementsPtrs, const BOX &boundingBox, int depth=6, int nodeCapacity=6){
+        buildTree(inputElementsPtrs,boundingBox,depth,nodeCapacity);
+    }
+    virtual ~OrthantTreeFast(){}
+    virtual void setElements(const ELEMENTS_PTR &inputElementsPtrs, const BOX &boundingBox, int depth=6, int nodeCapacity=6){
+        buildTree(inputElementsPtrs,boundingBox,depth,nodeCapacity);
+    }
+    virtual ELEMENTS_PTR getElementsThatOverlap(const ELEMENT_BOX &aabb) const{
+        SET elementIdSet;
+        getElementsThatOverlapRecursively(elementIdSet,aabb,toAABBN(aabb),rootId);
+        ELEMENTS_PTR overlappingElementsPtrs;
+        overlappingElementsPtrs.reserve(elementIdSet.size());
+        for(auto id: elementIdSet){
+            overlappingElementsPtrs.push_back(elementsPtrs.at(id));
+        }
+        return overlappingElementsPtrs;
+    }
+    virtual ELEMENTS_PTR getAllOverlappingElements() const{
+        SET elementIdSet;
+        QuadTreeQueryStats stats;
+        getAllOverlappingElementsRecursively(elementIdSet,rootId,stats);
+        addQueryStats(stats);
+        ELEMENTS_PTR overlappingElementsPtrs;
+        overlappingElementsPtrs.reserve(elementIdSet.size());
+        for(auto id: elementIdSet){
+            overlappingElementsPtrs.push_back(elementsPtrs.at(id));
+        }
+        return overlappingElementsPtrs;
+    }
+    //May return the same pair more than once if both elements overlap several leafs
+    virtual vector<tuple<ELEMENT_PTR,ELEMENT_PTR>> getAllOverlappingElementTuples() const{
+        vector<tuple<ELEMENT_PTR,ELEMENT_PTR>> overlappingTuples;
+        QuadTreeQueryStats stats;
+        getAllOverlappingElementTuplesRecursively(overlappingTuples,vector<int>(),rootId,stats);
+        addQueryStats(stats);
+        return overlappingTuples;
+    }
+    /*
+     * Pairs of overlapping elements where first element is from this tree and second is from other tree,
+     * both trees are descended at once. Each pair is returned once, pairs that overlap only outside common part
+     * of both root boxes are not reported
+     */
+    vector<tuple<ELEMENT_PTR,ELEMENT_PTR>> getOverlappingTuples(const OrthantTreeFast &other) const{
+        vector<tuple<ELEMENT_PTR,ELEMENT_PTR>> overlappingTuples;
+        if(rootId != -1 && other.rootId != -1){
+            const BOX &rootBox = boundingBoxes.at(rootId);
+            const BOX &otherRootBox = other.boundingBoxes.at(other.rootId);
+            BOX commonRootBox;
+            StaticFor<0,D>::apply([&](int i){
+                commonRootBox.min[i] = std::max(rootBox.min[i],otherRootBox.min[i]);
+                commonRootBox.max[i] = std::min(rootBox.max[i],otherRootBox.max[i]);
+            });
+            if(rootBox.doesOverlap(otherRootBox)){
+                DualTraversal traversal{*this,other,commonRootBox,overlappingTuples};
+                traversal.getDual(rootId,other.rootId);
+            }
+        }
+        return overlappingTuples;
+    }
+    /*
+     * When enabled setElements sorts elements by Hilbert index of their centers inside root box before building,
+     * so ids of elements that are close in space are close too. Sorting is parallel radix sort with threadsNumber threads,
+     * they are started here and reused by every build. Queries still return pointers given by caller
+     */
+    void setHilbertOrder(bool enabled, int threadsNumber = 1){
+        static_assert(D == 2, "Hilbert order is implemented for two dimensions only");
+        hilbertOrder = enabled;
+        hilbertOrderPool.reset(new ParallelForPool(enabled ? threadsNumber : 1));
+    }
+    //Elements in internal id order
+    const ELEMENTS_PTR &getElements() const{
+        return elementsPtrs;
+    }
+    /*
+     * Integral trees whose root box sides are powers of two are split with shifts and center comparisons by default.
+     * Disabling it makes such roots use generic split, result is the same
+     */
+    void setPowerOfTwoSplit(bool enabled){
+        powerOfTwoSplitEnabled = enabled;
+    }
+    //Maps internal element id to index in setElements input, empty when Hilbert order is disabled
+    const vector<int> &getElementsOrder() const{
+        return elementsOrder;
+    }
+    virtual void reset(){
+        nodes.clear();
+        elementsPtrs.clear();
+        elementsOrder.clear();
+        nodeIdToElementId.clear();
+        leafElements.clear();
+        boundingBoxes.clear();
+        rootId=-1;
+        powerOfTwoSplit=false;
+    }
+    virtual const OrthantTreeFastVisualionHelper<T,D,ELEMENT> *getVisualisationHelper() const{
+        return &visualisationHelper;
+    }
+    virtual QuadTreeQueryStats getQueryStats() const{
+        std::lock_guard<std::mutex> lock(queryStatsMutex);
+        return queryStats;
+    }
+    virtual void resetQueryStats(){
+        std::lock_guard<std::mutex> lock(queryStatsMutex);
+        queryStats = QuadTreeQueryStats();
+    }
+    virtual QuadTreeStats getStats() const{
+        QuadTreeStats stats;
+        stats.nodesNumber = nodes.size();
+        stats.leafQuantizationBits = leafQuantizationBits;
+        for(int nodeId=0;nodeId<nodes.size();nodeId++){
+            stats.elementReferencesNumber += getElementsNumber(nodeId);
+            if(nodes.at(nodeId).isLeaf()){
+                stats.leavesNumber++;
+            }
+        }
+        stats.leafBoxesBytes = leafElements.size() * sizeof(LeafElement);
+        return stats;
+    }
+
+protected:
+    virtual void buildTree(const ELEMENTS_PTR &inputElementsPtrs,
+                           const BOX &boundingBox,
+                           int depth,
+                           int nodeCapacity){
+        reset();
+        if(hilbertOrder){
+            sortByHilbertIndex(inputElementsPtrs,boundingBox);
+        }else{
+            elementsPtrs = inputElementsPtrs;
+        }
+        vector<int> elementsId(elementsPtrs.size());
+        for(int i=0;i<elementsPtrs.size();i++){
+            elementsId.at(i) = i;
+        }
+        powerOfTwoSplit = powerOfTwoSplitEnabled && isPowerOfTwoBox(boundingBox,std::is_integral<T>());
+        if(powerOfTwoSplit && elementsId.size() > nodeCapacity && depth > 0){
+            //Children are classified by comparing with node center only, which is valid for elements that overlap node.
+            //Elements outside of the root box would be dropped during split anyway
+            elementsId.erase(std::remove_if(elementsId.begin(),elementsId.end(),[&](int elementId){
+                return !toAABBN(elementsPtrs.at(elementId)->aabb).doesOverlap(boundingBox);
+            }),elementsId.end());
+        }
+        rootId = makeSubtree(elementsId,boundingBox,depth,nodeCapacity);
+    }
+    //Fills elementsPtrs and elementsOrder with input sorted by Hilbert index of element centers
+    void sortByHilbertIndex(const ELEMENTS_PTR &inputElementsPtrs, const BOX &boundingBox){
+        int elementsNumber = inputElementsPtrs.size();
+        vector<uint32_t> keys(elementsNumber);
+        elementsOrder.resize(elementsNumber);
+        double width = (double) boundingBox.max[0] - boundingBox.min[0];
+        double height = (double) boundingBox.max[1] - boundingBox.min[1];
+        hilbertOrderPool->parallelFor(0,elementsNumber,[&](int begin, int end){
+            for(int i=begin;i<end;i++){
+                const BOX &aabb = toAABBN(inputElementsPtrs[i]->aabb);
+                double x = ((double) aabb.min[0] + aabb.max[0]) / 2 - boundingBox.min[0];
+                double y = ((double) aabb.min[1] + aabb.max[1]) / 2 - boundingBox.min[1];
+                keys[i] = getHilbertIndex(toHilbertGrid(x,width),toHilbertGrid(y,height));
+                elementsOrder[i] = i;
+            }
+        });
+        parallelRadixSort(keys,elementsOrder,*hilbertOrderPool);
+        elementsPtrs.resize(elementsNumber);
+        for(int i=0;i<elementsNumber;i++){
+            elementsPtrs[i] = inputElementsPtrs[elementsOrder[i]];
+        }
+    }
+    //Position inside root box to one of 2^16 cells, positions outside of root are clamped
+    static uint32_t toHilbertGrid(double position, double size){
+        if(size <= 0) return 0;
+        double cell = position / size * 65535.0;
+        return static_cast<uint32_t>(std::min(std::max(cell,0.0),65535.0));
+    }
+    //Distance along Hilbert curve filling 2^16 x 2^16 grid
+    static uint32_t getHilbertIndex(uint32_t x, uint32_t y){
+        const uint32_t n = 1 << 16;
+        uint32_t index = 0;
+        for(uint32_t s=n/2;s>0;s/=2){
+            uint32_t rx = (x & s) > 0;
+            uint32_t ry = (y & s) > 0;
+            index += s * s * ((3 * rx) ^ ry);
+            //Rotate quadrant so that curve inside it starts in its corner
+            if(ry == 0){
+                if(rx == 1){
+                    x = n - 1 - x;
+                    y = n - 1 - y;
+                }
+                std::swap(x,y);
+            }
+        }
+        return index;
+    }
+    int makeSubtree(vector<int> &elementsId,
+                    const BOX &boundingBox,
+                    int levelRemaining,
+                    int nodeCapacity)
+    {
+        int rootId = nodes.size();
+        nodes.push_back(OrthantTreeFastNode<T,D>());
+        boundingBoxes.push_back(boundingBox);
+        if(elementsId.size() <= nodeCapacity || levelRemaining == 0){
+            makeLeafElements(elementsId,nodes.at(rootId));
+        }else{
+            const array<BOX,CHILDREN_NUMBER> childrenBoundingBoxes = powerOfTwoSplit ? splitPowerOfTwo(boundingBox,std::is_integral<T>()) : boundingBox.split();
+            auto elementsIdByChild = powerOfTwoSplit ?
+                        splitElementsIdByChildPowerOfTwo(elementsId,boundingBox,childrenBoundingBoxes) :
+                        splitElementsIdByChild(elementsId,boundingBox,childrenBoundingBoxes);
+            elementsId.clear();
+            nodeIdToElementId.insert(std::make_pair(rootId,std::move(elementsIdByChild.at(CHILDREN_NUMBER))));
+            for(int i=0;i<CHILDREN_NUMBER;i++){
+                int childId = makeSubtree(elementsIdByChild.at(i),childrenBoundingBoxes.at(i),levelRemaining-1,nodeCapacity);
+                nodes.at(rootId).childrenId.at(i) = childId;
+            }
+        }
+        return rootId;
+    }
+
+    /*
+     * Elements of subtree A against elements of subtree B is split into: elements of node A against elements of node B,
+     * elements of node A against subtrees of B's children (fixed A), subtrees of A's children against elements of node B (fixed B)
+     * and all pairs of children subtrees. Node pairs with not overlapping boxes are skipped.
+     * Elements can be stored in several nodes, so pair is reported only by nodes that contain its reference point:
+     * min corner of elements intersection clamped to common root box. Nodes are half open except at their root's max side
+     */
+    struct DualTraversal{
+        const OrthantTreeFast &treeA;
+        const OrthantTreeFast &treeB;
+        const BOX &commonRootBox;
+        vector<tuple<ELEMENT_PTR,ELEMENT_PTR>> &tuples;
+
+        void getDual(int nodeIdA, int nodeIdB) const{
+            if(!treeA.boundingBoxes.at(nodeIdA).doesOverlap(treeB.boundingBoxes.at(nodeIdB))) return;
+            compareNodes(nodeIdA,nodeIdB);
+            const OrthantTreeFastNode<T,D> &nodeA = treeA.nodes.at(nodeIdA);
+            const OrthantTreeFastNode<T,D> &nodeB = treeB.nodes.at(nodeIdB);
+            if(!nodeB.isLeaf()){
+                for(int childIdB: nodeB.childrenId){
+                    getFixedA(nodeIdA,childIdB);
+                }
+            }
+            if(!nodeA.isLeaf()){
+                for(int childIdA: nodeA.childrenId){
+                    getFixedB(childIdA,nodeIdB);
+                }
+            }
+            if(!nodeA.isLeaf() && !nodeB.isLeaf()){
+                for(int childIdA: nodeA.childrenId){
+                    for(int childIdB: nodeB.childrenId){
+                        getDual(childIdA,childIdB);
+                    }
+                }
+            }
+        }
+        void getFixedA(int nodeIdA, int nodeIdB) const{
+            if(treeA.getElementsNumber(nodeIdA) == 0 ||
+               !treeA.boundingBoxes.at(nodeIdA).doesOverlap(treeB.boundingBoxes.at(nodeIdB))) return;
+            compareNodes(nodeIdA,nodeIdB);
+            const OrthantTreeFastNode<T,D> &nodeB = treeB.nodes.at(nodeIdB);
+            if(!nodeB.isLeaf()){
+                for(int childIdB: nodeB.childrenId){
+                    getFixedA(nodeIdA,childIdB);
+                }
+            }
+        }
+        void getFixedB(int nodeIdA, int nodeIdB) const{
+            if(treeB.getElementsNumber(nodeIdB) == 0 ||
+               !treeA.boundingBoxes.at(nodeIdA).doesOverlap(treeB.boundingBoxes.at(nodeIdB))) return;
+            compareNodes(nodeIdA,nodeIdB);
+            const OrthantTreeFastNode<T,D> &nodeA = treeA.nodes.at(nodeIdA);
+            if(!nodeA.isLeaf()){
+                for(int childIdA: nodeA.childrenId){
+                    getFixedB(childIdA,nodeIdB);
+                }
+            }
+        }
+        void compareNodes(int nodeIdA, int nodeIdB) const{
+            const BOX &boxA = treeA.boundingBoxes.at(nodeIdA);
+            const BOX &boxB = treeB.boundingBoxes.at(nodeIdB);
+            const BOX &rootBoxA = treeA.boundingBoxes.at(treeA.rootId);
+            const BOX &rootBoxB = treeB.boundingBoxes.at(treeB.rootId);
+            treeA.forEachElementId(nodeIdA,[&](int elementIdA){
+                ELEMENT_PTR elementA = treeA.elementsPtrs.at(elementIdA);
+                const BOX &aabbA = toAABBN(elementA->aabb);
+                treeB.forEachElementId(nodeIdB,[&](int elementIdB){
+                    ELEMENT_PTR elementB = treeB.elementsPtrs.at(elementIdB);
+                    if(!elementA->doesOverlap(elementB->aabb)) return;
+                    const BOX &aabbB = toAABBN(elementB->aabb);
+                    array<T,D> point;
+                    StaticFor<0,D>::apply([&](int i){
+                        point[i] = std::min(std::max(std::max(aabbA.min[i],aabbB.min[i]),commonRootBox.min[i]),commonRootBox.max[i]);
+                    });
+                    if(containsReferencePoint(boxA,rootBoxA,point) && containsReferencePoint(boxB,rootBoxB,point)){
+                        tuples.push_back(tuple<ELEMENT_PTR,ELEMENT_PTR>(elementA,elementB));
+                    }
+                });
+            });
+        }
+        static bool containsReferencePoint(const BOX &box, const BOX &rootBox, const array<T,D> &point){
+            return StaticFor<0,D>::all([&](int i){
+                return box.min[i] <= point[i] && (point[i] < box.max[i] || box.max[i] == rootBox.max[i]);
+            });
+        }
+    };
+
+    /*
+     * Leaf elements are appended to leafElements. Quantized boxes are relative to tight bounds of leaf elements,
+     * so elements sticking out of leaf are encoded without clamping
+     */
+    void makeLeafElements(const vector<int> &elementsId, OrthantTreeFastNode<T,D> &node){
+        node.leafElementsBegin = leafElements.size();
+        if(!elementsId.empty()){
+            BOX referenceBox = toAABBN(elementsPtrs.at(elementsId.front())->aabb);
+            for(auto elementId: elementsId){
+                const BOX &aabb = toAABBN(elementsPtrs.at(elementId)->aabb);
+                StaticFor<0,D>::apply([&](int i){
+                    referenceBox.min[i] = std::min(referenceBox.min[i],aabb.min[i]);
+                    referenceBox.max[i] = std::max(referenceBox.max[i],aabb.max[i]);
+                });
+            }
+            for(auto elementId: elementsId){
+                leafElements.push_back(LeafElement{makeLeafBox(toAABBN(elementsPtrs.at(elementId)->aabb),referenceBox),elementId});
+            }
+        }
+        node.leafElementsEnd = leafElements.size();
+    }
+    static LEAF_BOX makeLeafBox(const BOX &aabb, const BOX &referenceBox){
+        return makeLeafBox(aabb,referenceBox,std::integral_constant<bool,leafQuantizationBits == 0>());
+    }
+    static BOX makeLeafBox(const BOX &aabb, const BOX &, std::true_type){
+        return aabb;
+    }
+    static QUANTIZED_BOX makeLeafBox(const BOX &aabb, const BOX &referenceBox, std::false_type){
+        return QUANTIZED_BOX(aabb,referenceBox);
+    }
+    static bool mayOverlap(const BOX &a, const BOX &b){
+        return a.doesOverlap(b);
+    }
+    static bool mayOverlap(const QUANTIZED_BOX &a, const QUANTIZED_BOX &b){
+        return a.mayOverlap(b);
+    }
+    //Cheap test on leaf boxes, elements are dereferenced for exact test only if it passes
+    bool doLeafElementsOverlap(const LeafElement &a, const LeafElement &b) const{
+        return mayOverlap(a.aabb,b.aabb) && elementsPtrs[a.elementId]->doesOverlap(elementsPtrs[b.elementId]->aabb);
+    }
+    int getElementsNumber(int nodeId) const{
+        const auto &node = nodes.at(nodeId);
+        return node.isLeaf() ? node.leafElementsEnd - node.leafElementsBegin : nodeIdToElementId.at(nodeId).size();
+    }
+    template <class FUNCTION>
+    void forEachElementId(int nodeId, FUNCTION &&function) const{
+        const auto &node = nodes.at(nodeId);
+        if(node.isLeaf()){
+            for(int i=node.leafElementsBegin;i<node.leafElementsEnd;i++){
+                function(leafElements[i].elementId);
+            }
+        }else{
+            for(int elementId: nodeIdToElementId.at(nodeId)){
+                function(elementId);
+            }
+        }
+    }
+
+    //Last entry holds elements that cover whole node
+    array<vector<int>,CHILDREN_NUMBER+1> splitElementsIdByChild(const vector<int> &elementsId, const BOX &boundingBox, const array<BOX,CHILDREN_NUMBER> &childrenBoundingBoxes) const{
+        array<vector<int>,CHILDREN_NUMBER+1> elementsIdByChild;
+        for(auto elementId: elementsId){
+            const BOX &aabb = toAABBN(elementsPtrs.at(elementId)->aabb);
+            if(boundingBox.isCompletlyInside(aabb)){
+                elementsIdByChild.at(CHILDREN_NUMBER).push_back(elementId);
+            }else{
+                for(int i=0;i<CHILDREN_NUMBER;i++){
+                    if(aabb.doesOverlap(childrenBoundingBoxes.at(i))){
+                        elementsIdByChild.at(i).push_back(elementId);
+                    }
+                }
+            }
+        }
+        return elementsIdByChild;
+    }
+
+    static bool isPowerOfTwoBox(const BOX &boundingBox, std::true_type){
+        return StaticFor<0,D>::all([&](int i){
+            T size = boundingBox.max[i] - boundingBox.min[i];
+            return size > 0 && (size & (size - 1)) == 0;
+        });
+    }
+    static bool isPowerOfTwoBox(const BOX &, std::false_type){
+        return false;
+    }
+    static array<BOX,CHILDREN_NUMBER> splitPowerOfTwo(const BOX &boundingBox, std::true_type){
+        return boundingBox.splitPowerOfTwo();
+    }
+    static array<BOX,CHILDREN_NUMBER> splitPowerOfTwo(const BOX &boundingBox, std::false_type){
+        return boundingBox.split();
+    }
+    /*
+     * Gives the same result as splitElementsIdByChild if all elements overlap boundingBox.
+     * Then element overlaps upper/lower half of the node along axis iff its max/min is past the center,
+     * so children are found with 2*D comparisons instead of 2^D doesOverlap calls
+     */
+    array<vector<int>,CHILDREN_NUMBER+1> splitElementsIdByChildPowerOfTwo(const vector<int> &elementsId, const BOX &boundingBox, const array<BOX,CHILDREN_NUMBER> &childrenBoundingBoxes) const{
+        //Child with all bits set is lower half along every axis, its max corner is node center
+        const array<T,D> &center = childrenBoundingBoxes.at(CHILDREN_NUMBER-1).max;
+        array<vector<int>,CHILDREN_NUMBER+1> elementsIdByChild;
+        for(auto elementId: elementsId){
+            const BOX &aabb = toAABBN(elementsPtrs.at(elementId)->aabb);
+            if(boundingBox.isCompletlyInside(aabb)){
+                elementsIdByChild.at(CHILDREN_NUMBER).push_back(elementId);
+            }else{
+                //Bit (D-1-i) is set if element reaches lower/upper half along axis i, like in child indices
+                int lowerBits = 0, upperBits = 0;
+                StaticFor<0,D>::apply([&](int i){
+                    if(aabb.min[i] < center[i]) lowerBits |= 1 << (D-1-i);
+                    if(aabb.max[i] > center[i]) upperBits |= 1 << (D-1-i);
+                });
+                for(int i=0;i<CHILDREN_NUMBER;i++){
+                    if((i & ~lowerBits) == 0 && (~i & ~upperBits & (CHILDREN_NUMBER-1)) == 0){
+                        elementsIdByChild[i].push_back(elementId);
+                    }
+                }
+            }
+        }
+        return elementsIdByChild;
+    }
+
+    void getElementsThatOverlapRecursively(SET &elementSet, const ELEMENT_BOX &aabb, const BOX &box, int nodeId) const{
+        if(nodeId == -1 || !boundingBoxes.at(nodeId).doesOverlap(box)) return;
+        forEachElementId(nodeId,[&](int elementId){
+            if(elementsPtrs.at(elementId)->doesOverlap(aabb)){
+                elementSet.insert(elementId);
+            }
+        });
+        const auto &node = nodes.at(nodeId);
+        if(!node.isLeaf()){
+            for(int childId: node.childrenId){
+                getElementsThatOverlapRecursively(elementSet,aabb,box,childId);
+            }
+        }
+    }
+
+    void getAllOverlappingElementsRecursively(SET &elementSet, int nodeId, QuadTreeQueryStats &stats) const{
+        if(nodeId != -1){
+            const auto &node = nodes.at(nodeId);
+            if(queryCounters) stats.nodesVisited++;
+            if(node.isLeaf()){
+                if(queryCounters) stats.leavesVisited++;
+                for(int i=node.leafElementsBegin;i<node.leafElementsEnd;i++){
+                    for(int j=i+1;j<node.leafElementsEnd;j++){
+                        if(queryCounters) stats.candidatePairs++;
+                        if(doLeafElementsOverlap(leafElements[i],leafElements[j])){
+                            if(queryCounters) stats.emittedPairs++;
+                            elementSet.insert(leafElements[i].elementId);
+                            elementSet.insert(leafElements[j].elementId);
+                        }
+                    }
+                }
+            }else{
+                const vector<int> &elementsId = nodeIdToElementId.at(nodeId);
+                elementSet.insert(elementsId.begin(),elementsId.end());
+                for(int childId: node.childrenId){
+                    getAllOverlappingElementsRecursively(elementSet,childId,stats);
+                }
+            }
+        }
+    }
+
+    void getAllOverlappingElementTuplesRecursively(vector<tuple<ELEMENT_PTR,ELEMENT_PTR>> &tuples,const vector<int> &elementsIdUpperNode, int nodeId, QuadTreeQueryStats &stats) const{
+        if(nodeId != -1){
+            const auto &node = nodes.at(nodeId);
+            if(queryCounters) stats.nodesVisited++;
+            if(node.isLeaf()){
+                if(queryCounters) stats.leavesVisited++;
+                for(int i=node.leafElementsBegin;i<node.leafElementsEnd;i++){
+                    for(int j=i+1;j<node.leafElementsEnd;j++){
+                        if(queryCounters) stats.candidatePairs++;
+                        if(doLeafElementsOverlap(leafElements[i],leafElements[j])){
+                            if(queryCounters) stats.emittedPairs++;
+                            tuples.push_back(tuple<ELEMENT_PTR,ELEMENT_PTR>(
+                                                 elementsPtrs[leafElements[i].elementId],
+                                                 elementsPtrs[leafElements[j].elementId]));
+                        }
+                    }
+                }
+                //all elementsIdUpperNode intersect entire bounding box and all elements of current node
+                if(queryCounters) countAncestorPairs(stats,(long long) (node.leafElementsEnd - node.leafElementsBegin) * elementsIdUpperNode.size());
+                for(int i=node.leafElementsBegin;i<node.leafElementsEnd;i++){
+                    for(int upperElementId: elementsIdUpperNode){
+                        tuples.push_back(tuple<ELEMENT_PTR,ELEMENT_PTR>(
+                                             elementsPtrs[leafElements[i].elementId],
+                                             elementsPtrs[upperElementId]));
+                    }
+                }
+            }else{
+                const vector<int> &elementsId = nodeIdToElementId.at(nodeId);
+                if(elementsId.size()>1){
+                    if(queryCounters) countAncestorPairs(stats,elementsId.size() * (elementsId.size() - 1) / 2);
+                    for(int i=0;i<elementsId.size();i++){
+                        for(int j=i+1;j<elementsId.size();j++){
+                            tuples.push_back(tuple<ELEMENT_PTR,ELEMENT_PTR>(elementsPtrs.at(elementsId.at(i)),elementsPtrs.at(elementsId.at(j))));
+                        }
+                    }
+                }
+                //elementsIdUpperNode cover this node too, so they intersect all elements of current node
+                if(queryCounters) countAncestorPairs(stats,elementsId.size() * elementsIdUpperNode.size());
+                for(int i=0;i<elementsId.size();i++){
+                    for(int j=0;j<elementsIdUpperNode.size();j++){
+                        tuples.push_back(tuple<ELEMENT_PTR,ELEMENT_PTR>(
+                                             elementsPtrs.at(elementsId.at(i)),
+                                             elementsPtrs.at(elementsIdUpperNode.at(j))));
+                    }
+                }
+                if(elementsId.empty()){
+                    for(int childId: node.childrenId){
+                        getAllOverlappingElementTuplesRecursively(tuples,elementsIdUpperNode,childId,stats);
+                    }
+                }else{
+                    vector<int> elementsIdWithUpperNode = elementsId;
+                    elementsIdWithUpperNode.insert(elementsIdWithUpperNode.end(),elementsIdUpperNode.begin(),elementsIdUpperNode.end());
+                    for(int childId: node.childrenId){
+                        getAllOverlappingElementTuplesRecursively(tuples,elementsIdWithUpperNode,childId,stats);
+                    }
+                }
+            }
+        }
+    }
+
+    static void countAncestorPairs(QuadTreeQueryStats &stats, long long pairsNumber){
+        stats.emittedPairs += pairsNumber;
+        stats.ancestorPairs += pairsNumber;
+    }
+    void addQueryStats(const QuadTreeQueryStats &stats) const{
+        if(!queryCounters) return;
+        std::lock_guard<std::mutex> lock(queryStatsMutex);
+        queryStats.add(stats);
+    }
+
+    vector<OrthantTreeFastNode<T,D>> nodes;
+    vector<BOX> boundingBoxes;
+    ELEMENTS_PTR elementsPtrs;
+    //Elements of non leaf nodes, elements of leafs are in leafElements
+    MAP nodeIdToElementId;
+    vector<LeafElement> leafElements;
+    int rootId=-1;
+    //Set for integral T when root box sides are powers of two
+    bool powerOfTwoSplit=false;
+    bool powerOfTwoSplitEnabled=true;
+    bool hilbertOrder=false;
+    unique_ptr<ParallelForPool> hilbertOrderPool{new ParallelForPool()};
+    vector<int> elementsOrder;
+    //Sum of stats of finished queries
+    mutable QuadTreeQueryStats queryStats;
+    mutable std::mutex queryStatsMutex;
+    OrthantTreeFastVisualionHelper<T,D,ELEMENT> visualisationHelper{this};
+};
+
+template <class T>
+using OctreeFast = OrthantTreeFast<T,3>;
+
+template <class T, int D, class ELEMENT>
+class OrthantTreeFastVisualionHelper{
+public:
+    OrthantTreeFastVisualionHelper(OrthantTreeFast<T,D,ELEMENT>* tree): tree(tree){}
+    //Boxes are in depth first order
+    vector<AABBN<T,D>> getNonLeafNodesBoundingBoxes() const{
+        vector<AABBN<T,D>> boundingBoxes;
+        for(int nodeId=0;nodeId<tree->nodes.size();nodeId++){
+            if(!tree->nodes.at(nodeId).isLeaf()){
+                boundingBoxes.push_back(tree->boundingBoxes.at(nodeId));
+            }
+        }
+        return boundingBoxes;
+    }
+private:
+    OrthantTreeFast<T,D,ELEMENT>* tree;
+};
+
+#endif // QUAD_TREE_ORTHANT_H
@@ -0,0 +1,149 @@
+#ifndef QUAD_TREE_PAIR_MANAGER_H
+#define QUAD_TREE_PAIR_MANAGER_H
+#include <functional>
+
+#include "quad_tree.h"
+
+/*
+ * Keeps overlapping pairs between frames and reports only pairs that started or stopped overlapping.
+ * Pairs are stored with lower pointer first in open addressing hash table together with number of last update that reported them.
+ * Update marks every reported pair in O(1) and then sweeps pairs that were not marked, so nothing has to be sorted.
+ * Swept pairs leave tombstones that are dropped when table is rehashed.
+ * Works with any QuadTree<T> since only getAllOverlappingElementTuples is used
+ */
+template <class T>
+class QuadTreePairManager{
+public:
+    typedef typename QuadTree<T>::ELEMENT_PTR ELEMENT_PTR;
+    typedef std::pair<ELEMENT_PTR,ELEMENT_PTR> PAIR;
+    typedef std::function<void(ELEMENT_PTR,ELEMENT_PTR)> PAIR_EVENT_HANDLER;
+
+public:
+    QuadTreePairManager(){}
+    QuadTreePairManager(PAIR_EVENT_HANDLER onBegin, PAIR_EVENT_HANDLER onEnd):onBegin(onBegin),onEnd(onEnd){}
+    void setOnBegin(PAIR_EVENT_HANDLER handler){
+        onBegin = handler;
+    }
+    void setOnEnd(PAIR_EVENT_HANDLER handler){
+        onEnd = handler;
+    }
+    void update(const QuadTree<T> &quadTree){
+        update(quadTree.getAllOverlappingElementTuples());
+    }
+    void update(const vector<tuple<ELEMENT_PTR,ELEMENT_PTR>> &overlappingTuples){
+        updateId++;
+        reserve(overlappingTuples.size());
+        for(auto &overlappingTuple: overlappingTuples){
+            PAIR pair = makePair(std::get<0>(overlappingTuple),std::get<1>(overlappingTuple));
+            if(mark(pair) && onBegin) onBegin(pair.first,pair.second);
+        }
+        for(auto &slot: table){
+            if(slot.pair.first != nullptr && slot.updateId != ERASED && slot.updateId != updateId){
+                if(onEnd) onEnd(slot.pair.first,slot.pair.second);
+                slot.updateId = ERASED;
+                pairsNumber--;
+                erasedNumber++;
+            }
+        }
+    }
+    //Pairs that overlapped during last update in no particular order
+    vector<PAIR> getPairs() const{
+        vector<PAIR> pairs;
+        pairs.reserve(pairsNumber);
+        for(auto &slot: table){
+            if(slot.pair.first != nullptr && slot.updateId != ERASED) pairs.push_back(slot.pair);
+        }
+        return pairs;
+    }
+    size_t getPairsNumber() const{
+        return pairsNumber;
+    }
+    //Forgets all pairs without reporting their end
+    void reset(){
+        table.clear();
+        pairsNumber = 0;
+        erasedNumber = 0;
+    }
+
+protected:
+    static const unsigned int ERASED = 0;
+    //Empty slot has null pair.first, erased one keeps its pair
+    struct Slot{
+        PAIR pair{nullptr,nullptr};
+        unsigned int updateId = ERASED;
+    };
+
+    static PAIR makePair(ELEMENT_PTR element0, ELEMENT_PTR element1){
+        if(std::less<ELEMENT_PTR>()(element1,element0)) std::swap(element0,element1);
+        return PAIR(element0,element1);
+    }
+    static size_t getHash(const PAIR &pair){
+        size_t hash0 = std::hash<ELEMENT_PTR>()(pair.first);
+        size_t hash1 = std::hash<ELEMENT_PTR>()(pair.second);
+        size_t hash = hash0 * 0x9E3779B1u ^ (hash1 + (hash0 << 6) + (hash0 >> 2));
+        //Pointers are aligned, so low bits have to be mixed with high ones
+        return hash ^ (hash >> 15) ^ (hash >> 29);
+    }
+    //Sets pair's update id, returns true if pair was not in table
+    bool mark(const PAIR &pair){
+        size_t mask = table.size() - 1;
+        Slot *erasedSlot = nullptr;
+        for(size_t slotId = getHash(pair) & mask;;slotId = (slotId + 1) & mask){
+            Slot &slot = table[slotId];
+            if(slot.pair.first == nullptr){
+                if(erasedSlot != nullptr){
+                    erasedNumber--;
+                }else{
+                    erasedSlot = &slot;
+                }
+                erasedSlot->pair = pair;
+                erasedSlot->updateId = updateId;
+                pairsNumber++;
+                return true;
+            }
+            if(slot.pair == pair){
+                if(slot.updateId == ERASED){
+                    slot.updateId = updateId;
+                    erasedNumber--;
+                    pairsNumber++;
+                    return true;
+                }
+                slot.updateId = updateId;
+                return false;
+            }
+            if(slot.updateId == ERASED && erasedSlot == nullptr) erasedSlot = &slot;
+        }
+    }
+    /*
+     * Keeps at most half of table occupied by pairs and tombstones even if all new pairs are added.
+     * Every update sweeps whole table, so it is also shrunk when it is much bigger than needed
+     */
+    void reserve(size_t newPairsNumber){
+        bool isTooSmall = 2 * (pairsNumber + erasedNumber + newPairsNumber) > table.size();
+        bool isTooBig = table.size() > 16 && 8 * (pairsNumber + newPairsNumber) < table.size();
+        if(!isTooSmall && !isTooBig) return;
+        size_t tableSize = 16;
+        while(tableSize < 2 * (pairsNumber + newPairsNumber)) tableSize *= 2;
+        vector<Slot> oldTable(tableSize);
+        std::swap(table,oldTable);
+        pairsNumber = 0;
+        erasedNumber = 0;
+        unsigned int currentUpdateId = updateId;
+        for(auto &slot: oldTable){
+            if(slot.pair.first != nullptr && slot.updateId != ERASED){
+                updateId = slot.updateId;
+                mark(slot.pair);
+            }
+        }
+        updateId = currentUpdateId;
+    }
+
+    PAIR_EVENT_HANDLER onBegin;
+    PAIR_EVENT_HANDLER onEnd;
+    vector<Slot> table;
+    size_t pairsNumber = 0;
+    size_t erasedNumber = 0;
+    unsigned int updateId = ERASED;
+};
+
+#endif // QUAD_TREE_PAIR_MANAGER_H
@@ -0,0 +1,154 @@
+#ifndef QUAD_TREE_PARALLEL_H
+#define QUAD_TREE_PARALLEL_H
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cstdint>
+
+/*
+ * Worker threads that are started once and reused by every parallelFor call, so call costs wake up of sleeping workers
+ * instead of creating and joining threads. Calls must come from one thread at a time
+ */
+class ParallelForPool{
+public:
+    ParallelForPool(int threadsNumber = 1){
+        for(int workerId=1;workerId<threadsNumber;workerId++){
+            workers.push_back(std::thread([this,workerId](){ run(workerId); }));
+        }
+    }
+    ParallelForPool(const ParallelForPool &) = delete;
+    ParallelForPool &operator=(const ParallelForPool &) = delete;
+    ~ParallelForPool(){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeUp.notify_all();
+        for(auto &worker: workers){
+            worker.join();
+        }
+    }
+    int getThreadsNumber() const{
+        return workers.size() + 1;
+    }
+    //Size of chunks [begin,end) is split into, every chunk except the last one has at least minChunkSize elements
+    int getChunkSize(int size, int minChunkSize = 1) const{
+        int chunksNumber = std::max(1,std::min(getThreadsNumber(),size / std::max(1,minChunkSize)));
+        return std::max(1,(size + chunksNumber - 1) / chunksNumber);
+    }
+    /*
+     * Splits [begin,end) into chunks of getChunkSize and calls function(chunkBegin,chunkEnd) for each of them.
+     * Calling thread processes the first chunk and returns when workers are done with the rest.
+     * Ranges too small to have two chunks of minChunkSize are processed by calling thread only
+     */
+    template <class FUNCTION>
+    void parallelFor(int begin, int end, const FUNCTION &function, int minChunkSize = 1){
+        int size = end - begin;
+        if(size <= 0) return;
+        int chunkSize = getChunkSize(size,minChunkSize);
+        int chunksNumber = (size + chunkSize - 1) / chunkSize;
+        if(chunksNumber == 1){
+            function(begin,end);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = Job{&invoke<FUNCTION>,&function,begin,end,chunkSize};
+            pendingChunksNumber = chunksNumber - 1;
+            jobId++;
+        }
+        wakeUp.notify_all();
+        function(begin,begin+chunkSize);
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock,[this](){ return pendingChunksNumber == 0; });
+    }
+
+protected:
+    struct Job{
+        void (*invoke)(const void*,int,int);
+        const void *function;
+        int begin;
+        int end;
+        int chunkSize;
+    };
+    template <class FUNCTION>
+    static void invoke(const void *function, int begin, int end){
+        (*static_cast<const FUNCTION*>(function))(begin,end);
+    }
+    //Worker with id i processes i-th chunk of every job, workers without chunk skip the job
+    void run(int workerId){
+        unsigned lastJobId = 0;
+        while(true){
+            Job currentJob;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeUp.wait(lock,[&](){ return stopping || jobId != lastJobId; });
+                if(stopping) return;
+                lastJobId = jobId;
+                currentJob = job;
+            }
+            int chunkBegin = currentJob.begin + workerId * currentJob.chunkSize;
+            if(chunkBegin >= currentJob.end) continue;
+            currentJob.invoke(currentJob.function,chunkBegin,std::min(chunkBegin+currentJob.chunkSize,currentJob.end));
+            std::lock_guard<std::mutex> lock(mutex);
+            if(--pendingChunksNumber == 0) done.notify_one();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::condition_variable done;
+    Job job;
+    unsigned jobId = 0;
+    int pendingChunksNumber = 0;
+    bool stopping = false;
+};
+
+/*
+ * Stable LSD radix sort of values by 32 bit keys, one byte per pass. Every pass counts digits of each parallelFor chunk,
+ * turns counts into per chunk offsets and then scatters chunks independently, so order of equal keys is kept
+ */
+template <class VALUE>
+void parallelRadixSort(std::vector<uint32_t> &keys, std::vector<VALUE> &values, ParallelForPool &pool){
+    int size = keys.size();
+    if(size <= 1) return;
+    //Same chunks as used by parallelFor
+    int chunkSize = pool.getChunkSize(size);
+    int chunksNumber = (size + chunkSize - 1) / chunkSize;
+    std::vector<std::array<int,256>> offsets(chunksNumber);
+    std::vector<uint32_t> keysBuffer(size);
+    std::vector<VALUE> valuesBuffer(size);
+    for(int shift=0;shift<32;shift+=8){
+        pool.parallelFor(0,size,[&](int begin, int end){
+            std::array<int,256> &counts = offsets.at(begin / chunkSize);
+            counts.fill(0);
+            for(int i=begin;i<end;i++){
+                counts[(keys[i] >> shift) & 255]++;
+            }
+        });
+        int offset = 0;
+        for(int digit=0;digit<256;digit++){
+            for(int chunk=0;chunk<chunksNumber;chunk++){
+                int count = offsets[chunk][digit];
+                offsets[chunk][digit] = offset;
+                offset += count;
+            }
+        }
+        pool.parallelFor(0,size,[&](int begin, int end){
+            std::array<int,256> &chunkOffsets = offsets.at(begin / chunkSize);
+            for(int i=begin;i<end;i++){
+                int position = chunkOffsets[(keys[i] >> shift) & 255]++;
+                keysBuffer[position] = keys[i];
+                valuesBuffer[position] = values[i];
+            }
+        });
+        keys.swap(keysBuffer);
+        values.swap(valuesBuffer);
+    }
+}
+
+#endif // QUAD_TREE_PARALLEL_H
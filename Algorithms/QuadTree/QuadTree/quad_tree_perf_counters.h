@@ -0,0 +1,145 @@
+#ifndef QUAD_TREE_PERF_COUNTERS_H
+#define QUAD_TREE_PERF_COUNTERS_H
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+enum class QUAD_TREE_PERF_COUNTER{CYCLES=0,INSTRUCTIONS,L1D_MISSES,LLC_MISSES,BRANCH_MISSES};
+constexpr int QUAD_TREE_PERF_COUNTERS_NUMBER = 5;
+
+/*
+ * Hardware counters of calling thread read with perf_event_open.
+ * Every counter is opened separately, so counters that are not supported by CPU, virtual machine
+ * or perf_event_paranoid setting are just marked as unavailable. On other systems nothing is available.
+ * When there are more counters than hardware registers kernel multiplexes them, so every value is
+ * scaled by time counter was enabled divided by time it was actually counting
+ */
+class QuadTreePerfCounters{
+public:
+    QuadTreePerfCounters(){
+        fileDescriptors.fill(-1);
+        values.fill(0);
+#ifdef __linux__
+        openCounter(QUAD_TREE_PERF_COUNTER::CYCLES,PERF_TYPE_HARDWARE,PERF_COUNT_HW_CPU_CYCLES);
+        openCounter(QUAD_TREE_PERF_COUNTER::INSTRUCTIONS,PERF_TYPE_HARDWARE,PERF_COUNT_HW_INSTRUCTIONS);
+        openCounter(QUAD_TREE_PERF_COUNTER::L1D_MISSES,PERF_TYPE_HW_CACHE,
+                    PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+        openCounter(QUAD_TREE_PERF_COUNTER::LLC_MISSES,PERF_TYPE_HARDWARE,PERF_COUNT_HW_CACHE_MISSES);
+        openCounter(QUAD_TREE_PERF_COUNTER::BRANCH_MISSES,PERF_TYPE_HARDWARE,PERF_COUNT_HW_BRANCH_MISSES);
+#endif
+    }
+    ~QuadTreePerfCounters(){
+#ifdef __linux__
+        for(int fileDescriptor: fileDescriptors){
+            if(fileDescriptor != -1) close(fileDescriptor);
+        }
+#endif
+    }
+    QuadTreePerfCounters(const QuadTreePerfCounters&) = delete;
+    QuadTreePerfCounters &operator=(const QuadTreePerfCounters&) = delete;
+
+    bool isAnyAvailable() const{
+        for(int fileDescriptor: fileDescriptors){
+            if(fileDescriptor != -1) return true;
+        }
+        return false;
+    }
+    bool isAvailable(QUAD_TREE_PERF_COUNTER counter) const{
+        return fileDescriptors.at(toIndex(counter)) != -1;
+    }
+    void start(){
+#ifdef __linux__
+        for(int fileDescriptor: fileDescriptors){
+            if(fileDescriptor == -1) continue;
+            ioctl(fileDescriptor,PERF_EVENT_IOC_RESET,0);
+            ioctl(fileDescriptor,PERF_EVENT_IOC_ENABLE,0);
+        }
+#endif
+    }
+    void stop(){
+#ifdef __linux__
+        for(int i=0;i<QUAD_TREE_PERF_COUNTERS_NUMBER;i++){
+            if(fileDescriptors.at(i) == -1) continue;
+            ioctl(fileDescriptors.at(i),PERF_EVENT_IOC_DISABLE,0);
+            //Layout given by PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING
+            uint64_t readValues[3] = {0,0,0};
+            values.at(i) = 0;
+            if(read(fileDescriptors.at(i),readValues,sizeof(readValues)) != sizeof(readValues)) continue;
+            uint64_t timeEnabled = readValues[1];
+            uint64_t timeRunning = readValues[2];
+            //Counter that was never scheduled has no estimate
+            if(timeRunning == 0) continue;
+            values.at(i) = timeRunning < timeEnabled ?
+                        static_cast<uint64_t>((double) readValues[0] * timeEnabled / timeRunning) : readValues[0];
+        }
+#endif
+    }
+    //Value counted between last start and stop, scaled if counter was multiplexed
+    uint64_t getValue(QUAD_TREE_PERF_COUNTER counter) const{
+        return values.at(toIndex(counter));
+    }
+    static std::string getName(QUAD_TREE_PERF_COUNTER counter){
+        switch(counter){
+        case QUAD_TREE_PERF_COUNTER::CYCLES: return "cycles";
+        case QUAD_TREE_PERF_COUNTER::INSTRUCTIONS: return "instructions";
+        case QUAD_TREE_PERF_COUNTER::L1D_MISSES: return "L1D misses";
+        case QUAD_TREE_PERF_COUNTER::LLC_MISSES: return "LLC misses";
+        case QUAD_TREE_PERF_COUNTER::BRANCH_MISSES: return "branch misses";
+        }
+        return "";
+    }
+    //Prints every available counter divided by given number, e.g. number of processed elements
+    void print(double divisor, const std::string &unit) const{
+        if(!isAnyAvailable()){
+            std::cout<<"   Hardware counters are not available"<<std::endl;
+            return;
+        }
+        std::cout<<"  ";
+        for(int i=0;i<QUAD_TREE_PERF_COUNTERS_NUMBER;i++){
+            QUAD_TREE_PERF_COUNTER counter = static_cast<QUAD_TREE_PERF_COUNTER>(i);
+            if(isAvailable(counter)){
+                std::cout<<" "<<getName(counter)<<": "<<getValue(counter)/divisor;
+            }else{
+                std::cout<<" "<<getName(counter)<<": n/a";
+            }
+        }
+        if(isAvailable(QUAD_TREE_PERF_COUNTER::CYCLES) && isAvailable(QUAD_TREE_PERF_COUNTER::INSTRUCTIONS) && getValue(QUAD_TREE_PERF_COUNTER::CYCLES) > 0){
+            std::cout<<" (IPC "<<(double) getValue(QUAD_TREE_PERF_COUNTER::INSTRUCTIONS)/getValue(QUAD_TREE_PERF_COUNTER::CYCLES)<<")";
+        }
+        std::cout<<" per "<<unit<<std::endl;
+    }
+
+protected:
+    static int toIndex(QUAD_TREE_PERF_COUNTER counter){
+        return static_cast<int>(counter);
+    }
+#ifdef __linux__
+    void openCounter(QUAD_TREE_PERF_COUNTER counter, uint32_t type, uint64_t config){
+        perf_event_attr attributes;
+        std::memset(&attributes,0,sizeof(attributes));
+        attributes.size = sizeof(attributes);
+        attributes.type = type;
+        attributes.config = config;
+        attributes.disabled = 1;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        long fileDescriptor = syscall(__NR_perf_event_open,&attributes,0,-1,-1,0);
+        fileDescriptors.at(toIndex(counter)) = fileDescriptor < 0 ? -1 : static_cast<int>(fileDescriptor);
+    }
+#endif
+
+    std::array<int,QUAD_TREE_PERF_COUNTERS_NUMBER> fileDescriptors;
+    std::array<uint64_t,QUAD_TREE_PERF_COUNTERS_NUMBER> values;
+};
+
+#endif // QUAD_TREE_PERF_COUNTERS_H
@@ -0,0 +1,54 @@
+#ifndef QUAD_TREE_SIMULATION_H
+#define QUAD_TREE_SIMULATION_H
+#include <array>
+#include <atomic>
+#include <vector>
+
+#include "quad_tree.h"
+
+//Everything needed to draw single simulation frame
+struct QuadTreeFrameSnapshot{
+    std::vector<AABB<int>> boxes;
+    //Per box flag, set if box overlaps any other box
+    std::vector<char> overlapping;
+    std::vector<AABB<int>> nodeBoxes;
+    //Quad tree nodes are drawn as crosses through their centre, nodes of other trees overlap and are drawn as boxes
+    bool nodesSplitAtCenter = true;
+    //Queries of the frame, empty unless QUAD_TREE_QUERY_COUNTERS is enabled
+    QuadTreeQueryStats queryStats;
+};
+
+/*
+ * Lock-free double buffering between single writer and single reader.
+ * Plain double buffer would make writer wait until reader is done with the front buffer,
+ * so there is third slot that is swapped atomically: writer always has slot to fill,
+ * reader keeps its slot until newer one is published and neither side ever blocks
+ */
+template <class T>
+class SnapshotBuffer{
+public:
+    //Writer side
+    T &getWriteBuffer(){
+        return buffers.at(writeIndex);
+    }
+    void publish(){
+        writeIndex = readyIndex.exchange(writeIndex | NEW_DATA_FLAG) & INDEX_MASK;
+    }
+    //Reader side, returns the latest published buffer
+    const T &getReadBuffer(){
+        if(readyIndex.load() & NEW_DATA_FLAG){
+            readIndex = readyIndex.exchange(readIndex) & INDEX_MASK;
+        }
+        return buffers.at(readIndex);
+    }
+
+protected:
+    static const int NEW_DATA_FLAG = 4;
+    static const int INDEX_MASK = 3;
+    std::array<T,3> buffers;
+    int writeIndex = 0;
+    int readIndex = 1;
+    std::atomic<int> readyIndex{2};
+};
+
+#endif // QUAD_TREE_SIMULATION_H
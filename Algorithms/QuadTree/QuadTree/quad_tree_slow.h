@@ -38,12 +38,13 @@ public:
         buildTree(inputElementsPtrs,boundingBox,depth,nodeCapacity);
     }
     virtual ELEMENTS_PTR getElementsThatOverlap(const AABB<T> &aabb) const override{
-        ELEMENTS_PTR result;
-        //TODO
-        return result;
+        ELEMENT_COMPARATOR comparator = [](const ELEMENT_PTR &x, const ELEMENT_PTR &y){ return x < y; };
+        ELEMENT_SET elementSet(comparator);
+        getElementsThatOverlapRecursively(elementSet,aabb,rootNode);
+        return ELEMENTS_PTR(elementSet.begin(),elementSet.end());
     }
     virtual ELEMENTS_PTR getAllOverlappingElements() const override{
-        ELEMENT_COMPARATOR comparator = [](const ELEMENT_PTR &x, const ELEMENT_PTR &y){ return x.get() < y.get(); };
+        ELEMENT_COMPARATOR comparator = [](const ELEMENT_PTR &x, const ELEMENT_PTR &y){ return x < y; };
         ELEMENT_SET elementSet(comparator);
         getAllOverlappingElementsRecursively(elementSet,rootNode);
         return ELEMENTS_PTR(elementSet.begin(),elementSet.end());
@@ -93,12 +94,25 @@ protected:
         }
         return elementsPtrsByQuadrant;
     }
+    void getElementsThatOverlapRecursively(ELEMENT_SET &elementSet, const AABB<T> &aabb, const NODE_SLOW_PTR &node) const{
+        if(node == nullptr || !node->boundingBox.doesOverlap(aabb)){
+            return;
+        }
+        for(auto const &element: node->elementsPtr){
+            if(element->doesOverlap(aabb)){
+                elementSet.insert(element);
+            }
+        }
+        for(auto const &child: node->children){
+            getElementsThatOverlapRecursively(elementSet,aabb,child);
+        }
+    }
     void getAllOverlappingElementTuplesRecursively(vector<tuple<ELEMENT_PTR,ELEMENT_PTR>> &tuples, const NODE_SLOW_PTR &node) const{
-        auto &elements = node->elementsPtr;
         if(node == nullptr){
             return;
         }
-        else if(elements.size()>1){
+        auto &elements = node->elementsPtr;
+        if(elements.size()>1){
             for(int i=0;i<elements.size();i++){
                 for(int j=i+1;j<elements.size();j++){
                     if(elements.at(i)->doesOverlap(elements.at(j)->aabb)){
@@ -115,11 +129,11 @@ protected:
     }
 
     void getAllOverlappingElementsRecursively(ELEMENT_SET &elementSet, const NODE_SLOW_PTR &node) const{
-        auto &nodeElements = node->elementsPtr;
         if(node == nullptr){
             return;
         }
-        else if(nodeElements.size()>1){
+        auto &nodeElements = node->elementsPtr;
+        if(nodeElements.size()>1){
             for(int i=0;i<nodeElements.size();i++){
                 for(int j=i+1;j<nodeElements.size();j++){
                     if(nodeElements.at(i)->doesOverlap(nodeElements.at(j)->aabb)){
@@ -0,0 +1,279 @@
+#ifndef QUAD_TREE_STR_H
+#define QUAD_TREE_STR_H
+#include <unordered_set>
+#include <cmath>
+
+#include "quad_tree.h"
+template <class T>
+class STRTree;
+template <class T>
+class STRTreeVisualionHelper;
+
+/*
+ * Static R-tree bulk loaded with Sort-Tile-Recursive packing.
+ * Unlike quad trees every element is referenced exactly once and node boxes are tight bounds of their children.
+ * Nodes are stored in level order (root first, leafs last) in flat arrays and children of each node are contiguous,
+ * so node is fully described by its bounding box, id of first child and number of children.
+ * Tree is meant for data that doesn't change every frame since any change requires full rebuild.
+ */
+template <class T>
+class STRTree: public QuadTree<T>{
+
+public:
+    typedef typename QuadTree<T>::ELEMENTS_PTR ELEMENTS_PTR;
+    typedef typename QuadTree<T>::ELEMENT_PTR ELEMENT_PTR;
+    typedef std::unordered_set<int> SET;
+
+    friend class STRTreeVisualionHelper<T>;
+
+public:
+    STRTree(int fanOut=16):fanOut(std::max(fanOut,2)){}
+    STRTree(const ELEMENTS_PTR &inputElementsPtrs, int fanOut=16):STRTree(fanOut){
+        buildTree(inputElementsPtrs);
+    }
+    virtual ~STRTree(){}
+    // Note: tree bounds come from elements, so boundingBox, depth and nodeCapacity are ignored
+    virtual void setElements(const ELEMENTS_PTR &inputElementsPtrs, const AABB<T> &/*boundingBox*/, int /*depth*/=6, int /*nodeCapacity*/=6) override{
+        buildTree(inputElementsPtrs);
+    }
+    virtual ELEMENTS_PTR getElementsThatOverlap(const AABB<T> &aabb) const override{
+        ELEMENTS_PTR overlappingElementsPtrs;
+        if(rootId != -1){
+            getElementsThatOverlapRecursively(overlappingElementsPtrs,aabb,rootId);
+        }
+        return overlappingElementsPtrs;
+    }
+    virtual ELEMENTS_PTR getAllOverlappingElements() const override{
+        SET elementIdSet;
+        if(rootId != -1){
+            getOverlappingElementIdPairsInSubtree(rootId,[&](int elementId0, int elementId1){
+                elementIdSet.insert(elementId0);
+                elementIdSet.insert(elementId1);
+            });
+        }
+        ELEMENTS_PTR overlappingElementsPtrs(elementIdSet.size());
+        int i=0;
+        for(auto id: elementIdSet){
+            overlappingElementsPtrs.at(i) = elementsPtrs.at(id);
+            i++;
+        }
+        return overlappingElementsPtrs;
+    }
+    virtual vector<tuple<ELEMENT_PTR,ELEMENT_PTR>> getAllOverlappingElementTuples() const override{
+        vector<tuple<ELEMENT_PTR,ELEMENT_PTR>> overlappingTuples;
+        if(rootId != -1){
+            getOverlappingElementIdPairsInSubtree(rootId,[&](int elementId0, int elementId1){
+                overlappingTuples.push_back(tuple<ELEMENT_PTR,ELEMENT_PTR>(elementsPtrs.at(elementId0),elementsPtrs.at(elementId1)));
+            });
+        }
+        return overlappingTuples;
+    }
+    virtual void reset() override{
+        boundingBoxes.clear();
+        firstChildId.clear();
+        childrenNumber.clear();
+        elementsId.clear();
+        elementsAABBs.clear();
+        elementsPtrs.clear();
+        firstLeafId = 0;
+        rootId = -1;
+    }
+    virtual const QuadTreeVisualionHelper<T> *getVisualisationHelper() const override{
+        return &visualisationHelper;
+    }
+    virtual QuadTreeStats getStats() const override{
+        QuadTreeStats stats;
+        stats.nodesNumber = boundingBoxes.size();
+        stats.leavesNumber = boundingBoxes.size() - firstLeafId;
+        stats.elementReferencesNumber = elementsId.size();
+        stats.leafBoxesBytes = elementsAABBs.size() * sizeof(AABB<T>);
+        return stats;
+    }
+    int getFanOut() const{
+        return fanOut;
+    }
+
+protected:
+    struct PackedNode{
+        AABB<T> boundingBox;
+        int firstChildId;
+        int childrenNumber;
+    };
+
+    void buildTree(const ELEMENTS_PTR &inputElementsPtrs){
+        reset();
+        elementsPtrs = inputElementsPtrs;
+        if(elementsPtrs.size() == 0) return;
+
+        //Leafs are made of elements, for element entries firstChildId holds element id
+        vector<PackedNode> elementEntries(elementsPtrs.size());
+        for(int i=0;i<elementsPtrs.size();i++){
+            elementEntries.at(i) = PackedNode{elementsPtrs.at(i)->aabb,i,0};
+        }
+        sortTileRecursive(elementEntries);
+        elementsId.resize(elementEntries.size());
+        elementsAABBs.resize(elementEntries.size());
+        for(int i=0;i<elementEntries.size();i++){
+            elementsId.at(i) = elementEntries.at(i).firstChildId;
+            elementsAABBs.at(i) = elementEntries.at(i).boundingBox;
+        }
+        //Levels are built bottom up, each level is packed from STR sorted nodes of level below
+        vector<vector<PackedNode>> levels;
+        levels.push_back(packLevel(elementEntries));
+        while(levels.back().size() > 1){
+            sortTileRecursive(levels.back());
+            levels.push_back(packLevel(levels.back()));
+        }
+        //Flatten levels in level order and convert children ids from level local to global ones
+        int levelOffset = 0;
+        for(int level=levels.size()-1;level>=0;level--){
+            int childLevelOffset = levelOffset + levels.at(level).size();
+            for(auto &node: levels.at(level)){
+                boundingBoxes.push_back(node.boundingBox);
+                firstChildId.push_back(level == 0 ? node.firstChildId : childLevelOffset + node.firstChildId);
+                childrenNumber.push_back(node.childrenNumber);
+            }
+            levelOffset = childLevelOffset;
+        }
+        firstLeafId = boundingBoxes.size() - levels.front().size();
+        rootId = 0;
+    }
+    //Orders entries so that every fanOut consecutive entries are spatially close
+    void sortTileRecursive(vector<PackedNode> &entries) const{
+        auto xCenterLess = [](const PackedNode &a, const PackedNode &b){
+            return a.boundingBox.xMin + a.boundingBox.xMax < b.boundingBox.xMin + b.boundingBox.xMax;
+        };
+        auto yCenterLess = [](const PackedNode &a, const PackedNode &b){
+            return a.boundingBox.yMin + a.boundingBox.yMax < b.boundingBox.yMin + b.boundingBox.yMax;
+        };
+        int nodesNumber = (entries.size() + fanOut - 1) / fanOut;
+        int slicesNumber = std::ceil(std::sqrt((double) nodesNumber));
+        int sliceSize = slicesNumber * fanOut;
+        std::sort(entries.begin(),entries.end(),xCenterLess);
+        for(int sliceBegin=0;sliceBegin<entries.size();sliceBegin+=sliceSize){
+            int sliceEnd = std::min<int>(sliceBegin+sliceSize,entries.size());
+            std::sort(entries.begin()+sliceBegin,entries.begin()+sliceEnd,yCenterLess);
+        }
+    }
+    //Groups every fanOut consecutive entries under single parent node
+    vector<PackedNode> packLevel(const vector<PackedNode> &entries) const{
+        vector<PackedNode> parents;
+        parents.reserve((entries.size() + fanOut - 1) / fanOut);
+        for(int first=0;first<entries.size();first+=fanOut){
+            int last = std::min<int>(first+fanOut,entries.size());
+            AABB<T> boundingBox = entries.at(first).boundingBox;
+            for(int i=first+1;i<last;i++){
+                const AABB<T> &childBox = entries.at(i).boundingBox;
+                boundingBox.xMin = std::min(boundingBox.xMin,childBox.xMin);
+                boundingBox.yMin = std::min(boundingBox.yMin,childBox.yMin);
+                boundingBox.xMax = std::max(boundingBox.xMax,childBox.xMax);
+                boundingBox.yMax = std::max(boundingBox.yMax,childBox.yMax);
+            }
+            parents.push_back(PackedNode{boundingBox,first,last-first});
+        }
+        return parents;
+    }
+    bool isLeaf(int nodeId) const{
+        return nodeId >= firstLeafId;
+    }
+    //Every element is stored once, so each overlapping pair is reported exactly once
+    template <class VISITOR>
+    void getOverlappingElementIdPairsInSubtree(int nodeId, VISITOR &&callback) const{
+        int first = firstChildId.at(nodeId);
+        int last = first + childrenNumber.at(nodeId);
+        if(isLeaf(nodeId)){
+            for(int i=first;i<last;i++){
+                for(int j=i+1;j<last;j++){
+                    reportIfOverlap(i,j,callback);
+                }
+            }
+        }else{
+            for(int i=first;i<last;i++){
+                getOverlappingElementIdPairsInSubtree(i,callback);
+                for(int j=i+1;j<last;j++){
+                    if(boundingBoxes.at(i).doesOverlap(boundingBoxes.at(j))){
+                        getOverlappingElementIdPairsBetweenSubtrees(i,j,callback);
+                    }
+                }
+            }
+        }
+    }
+    template <class VISITOR>
+    void getOverlappingElementIdPairsBetweenSubtrees(int nodeId0, int nodeId1, VISITOR &&callback) const{
+        if(isLeaf(nodeId0) && isLeaf(nodeId1)){
+            int last0 = firstChildId.at(nodeId0) + childrenNumber.at(nodeId0);
+            int last1 = firstChildId.at(nodeId1) + childrenNumber.at(nodeId1);
+            for(int i=firstChildId.at(nodeId0);i<last0;i++){
+                if(!elementsAABBs.at(i).doesOverlap(boundingBoxes.at(nodeId1))) continue;
+                for(int j=firstChildId.at(nodeId1);j<last1;j++){
+                    reportIfOverlap(i,j,callback);
+                }
+            }
+        }else{
+            //Descend into non leaf node, the other one stays the same
+            if(isLeaf(nodeId0)) std::swap(nodeId0,nodeId1);
+            int last = firstChildId.at(nodeId0) + childrenNumber.at(nodeId0);
+            for(int childId=firstChildId.at(nodeId0);childId<last;childId++){
+                if(boundingBoxes.at(childId).doesOverlap(boundingBoxes.at(nodeId1))){
+                    getOverlappingElementIdPairsBetweenSubtrees(childId,nodeId1,callback);
+                }
+            }
+        }
+    }
+    //i and j are positions in leaf order
+    template <class VISITOR>
+    void reportIfOverlap(int i, int j, VISITOR &&callback) const{
+        if(elementsAABBs.at(i).doesOverlap(elementsAABBs.at(j))){
+            int elementId0 = elementsId.at(i);
+            int elementId1 = elementsId.at(j);
+            if(elementsPtrs.at(elementId0)->doesOverlap(elementsPtrs.at(elementId1)->aabb)){
+                callback(elementId0,elementId1);
+            }
+        }
+    }
+    void getElementsThatOverlapRecursively(ELEMENTS_PTR &overlappingElementsPtrs, const AABB<T> &aabb, int nodeId) const{
+        int last = firstChildId.at(nodeId) + childrenNumber.at(nodeId);
+        if(isLeaf(nodeId)){
+            for(int i=firstChildId.at(nodeId);i<last;i++){
+                if(elementsAABBs.at(i).doesOverlap(aabb) && elementsPtrs.at(elementsId.at(i))->doesOverlap(aabb)){
+                    overlappingElementsPtrs.push_back(elementsPtrs.at(elementsId.at(i)));
+                }
+            }
+        }else{
+            for(int childId=firstChildId.at(nodeId);childId<last;childId++){
+                if(boundingBoxes.at(childId).doesOverlap(aabb)){
+                    getElementsThatOverlapRecursively(overlappingElementsPtrs,aabb,childId);
+                }
+            }
+        }
+    }
+
+    int fanOut;
+    //Per node data in level order
+    vector<AABB<T>> boundingBoxes;
+    vector<int> firstChildId;
+    vector<int> childrenNumber;
+    int firstLeafId = 0;
+    //Per element data in leaf order
+    vector<int> elementsId;
+    vector<AABB<T>> elementsAABBs;
+    ELEMENTS_PTR elementsPtrs;
+    int rootId = -1;
+    STRTreeVisualionHelper<T> visualisationHelper{this};
+};
+
+template <class T>
+class STRTreeVisualionHelper: public QuadTreeVisualionHelper<T>{
+public:
+    STRTreeVisualionHelper(STRTree<T>* tree): tree(tree){}
+    virtual vector<AABB<T>> getNonLeafNodesBoundingBoxes() const override{
+        return vector<AABB<T>>(tree->boundingBoxes.begin(),tree->boundingBoxes.begin()+tree->firstLeafId);
+    }
+    virtual bool areNodesSplitAtCenter() const override{
+        return false;
+    }
+private:
+    STRTree<T>* tree;
+};
+
+#endif // QUAD_TREE_STR_H
@@ -11,11 +11,22 @@
 #include <ctime>
 #include <cmath>
 #include <type_traits>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
 
 #include "quad_tree.h"
 #include "quad_tree_slow.h"
 #include "quad_tree_moderate.h"
 #include "quad_tree_fast.h"
+#include "quad_tree_str.h"
+#include "quad_tree_dynamic.h"
+#include "quad_tree_element_pool.h"
+#include "quad_tree_parallel.h"
+#include "quad_tree_simulation.h"
 using std::vector;
 using std::array;
 using std::shared_ptr;
@@ -28,50 +39,104 @@ struct MyCustomElement: public QuadTreeElement<int>{
     typedef QuadTreeElement<int>::ELEMENT_PTR ELEMENT_PTR;
     typedef MyCustomElement* Type;
 
-    MyCustomElement(){
-        init();
-    }
-    MyCustomElement(const AABB<int> &aabb, QColor color=Qt::yellow): QuadTreeElement(aabb), color(color){
-        pos = QVector2D(aabb.xMin,aabb.yMin);
-        init();
-    }
+    MyCustomElement(){}
+    MyCustomElement(const AABB<int> &aabb, QColor color=Qt::yellow): QuadTreeElement(aabb), color(color){}
     virtual ~MyCustomElement(){}
-    void init(){
-        QMatrix4x4 rotationMat;
-        rotationMat.rotate(rand()%360,0,0,1);
-        direction = (QVector2D(1,0).toVector4D()*rotationMat).toVector2D();
-        speed = 1+rand()%3;
-    }
 
     static MyCustomElement* makeElement(const AABB<int> &aabb, QColor color=Qt::yellow)
     {
       return new MyCustomElement(aabb,color);
     }
-    void update(){
-        pos = pos + direction * speed;
-        this->aabb.translateBy(pos.x()-this->aabb.xMin,pos.y()-this->aabb.yMin);
-    }
     QColor color;
-    float speed = 6;
-    QVector2D direction;
-    QVector2D pos;
+    //Position in holder, motion of element is kept at this index of MyCustomElementsState
+    int id = -1;
+};
+
+//Motion of all elements laid out as structure of arrays, elements keep only bounding boxes that are needed by tree
+struct MyCustomElementsState{
+    //Element starts at corner of its box and moves in random direction
+    void add(const AABB<int> &aabb){
+        QMatrix4x4 rotationMat;
+        rotationMat.rotate(rand()%360,0,0,1);
+        QVector2D direction = (QVector2D(1,0).toVector4D()*rotationMat).toVector2D();
+        posX.push_back(aabb.xMin);
+        posY.push_back(aabb.yMin);
+        directionX.push_back(direction.x());
+        directionY.push_back(direction.y());
+        speed.push_back(1+rand()%3);
+    }
+    void clear(){
+        posX.clear();
+        posY.clear();
+        directionX.clear();
+        directionY.clear();
+        speed.clear();
+    }
+    /*
+     * Turns element with given id away from the other element of pair along axis with smaller overlap.
+     * Only this element's direction changes, so pair is resolved by calling it for both elements.
+     * isElement0 tells which box of pair belongs to this element, it decides direction when centers are equal
+     */
+    void resolveCollision(int elementId, const AABB<int> &aabb0, const AABB<int> &aabb1, bool isElement0){
+        int width0 =  aabb0.xMax - aabb0.xMin;
+        int height0 = aabb0.yMax - aabb0.yMin;
+        int width1 =  aabb1.xMax - aabb1.xMin;
+        int height1 = aabb1.yMax - aabb1.yMin;
+        int x0Ctr = aabb0.xMin + width0 /2;
+        int y0Ctr = aabb0.yMin + height0/2;
+        int x1Ctr = aabb1.xMin + width1 /2;
+        int y1Ctr = aabb1.yMin + height1/2;
+        int xOverlap = std::abs(std::abs(x0Ctr-x1Ctr) - (width0+width1)/2);
+        int yOverlap = std::abs(std::abs(y0Ctr-y1Ctr) - (height0+height1)/2);
+        if(xOverlap < yOverlap){
+            float absDirectionX = std::abs(directionX[elementId]);
+            directionX[elementId] = (x0Ctr < x1Ctr) == isElement0 ? -absDirectionX : absDirectionX;
+        }else{
+            float absDirectionY = std::abs(directionY[elementId]);
+            directionY[elementId] = (y0Ctr < y1Ctr) == isElement0 ? -absDirectionY : absDirectionY;
+        }
+    }
+    //Bounces elements in [begin,end) from bounding box, then moves them and their boxes
+    void integrate(const vector<MyCustomElement*> &elementsPtrs, const AABB<int> &boundingBox, int begin, int end){
+        for(int i=begin;i<end;i++){
+            AABB<int> &aabb = elementsPtrs[i]->aabb;
+            if(aabb.xMin < boundingBox.xMin) directionX[i] =  std::abs(directionX[i]);
+            if(aabb.xMax > boundingBox.xMax) directionX[i] = -std::abs(directionX[i]);
+            if(aabb.yMin < boundingBox.yMin) directionY[i] =  std::abs(directionY[i]);
+            if(aabb.yMax > boundingBox.yMax) directionY[i] = -std::abs(directionY[i]);
+            posX[i] += directionX[i] * speed[i];
+            posY[i] += directionY[i] * speed[i];
+            aabb.translateBy(posX[i]-aabb.xMin,posY[i]-aabb.yMin);
+        }
+    }
+    vector<float> posX,posY;
+    vector<float> directionX,directionY;
+    vector<float> speed;
 };
 
 struct MyCustomElementsHolder{
-    MyCustomElementsHolder():quadTree(new QuadTreeFast<int>()){
+    //Holder takes ownership of given tree
+    MyCustomElementsHolder(QuadTree<int>* quadTree = new QuadTreeFast<int>()):quadTree(quadTree){
+        visualisationHelper = this->quadTree->getVisualisationHelper();
+    }
+    //Replaces tree used for collision detection, current elements are moved to the new one
+    void setQuadTree(QuadTree<int>* newQuadTree){
+        quadTree.reset(newQuadTree);
         visualisationHelper = quadTree->getVisualisationHelper();
+        vector<QuadTreeElement<int>::Type> elementsCastedPtrs(elementsPtrs.begin(),elementsPtrs.end());
+        quadTree->setElements(elementsCastedPtrs,boundingBox,treeDepth,treeNodeCapacity);
     }
     void addElement(const AABB<int> &aabb, QColor color=Qt::yellow){
-        elementsPtrs.push_back(MyCustomElement::makeElement(aabb,color));
+        pushElement(aabb,color);
         vector<QuadTreeElement<int>::Type> elementsCastedPtrs(elementsPtrs.begin(),elementsPtrs.end());
         quadTree->setElements(elementsCastedPtrs,AABB<int>(0,0,799,799));
     }
     void addElements(vector<AABB<int>> aabbs){
         for(auto aabb: aabbs){
-            elementsPtrs.push_back(MyCustomElement::makeElement(aabb));
+            pushElement(aabb);
         }
         vector<QuadTreeElement<int>::Type> elementsCastedPtrs(elementsPtrs.begin(),elementsPtrs.end());
-        quadTree->setElements(elementsCastedPtrs,boundingBox,6,4);
+        quadTree->setElements(elementsCastedPtrs,boundingBox,treeDepth,treeNodeCapacity);
     }
     vector<QuadTreeElement<int>::Type> getOverlappingObjects(){
         auto overlappingElements = quadTree->getAllOverlappingElements();
@@ -82,68 +147,324 @@ struct MyCustomElementsHolder{
         return overlappingElementsCasted;
     }
     void reset(){
-        elementsPtrs.clear();
         quadTree->reset();
+        elementsPtrs.clear();
+        elementsPool.reset();
+        state.clear();
     }
+    //Frames with fewer than parallelMinElementsNumber elements run on calling thread, waking workers would cost more than it saves
     void update(){
-
+        if(threadsPool && elementsPtrs.size() >= parallelMinElementsNumber){
+            updateParallel();
+        }else{
+            updateSerial();
+        }
+    }
+    void updateSerial(){
         auto overlappingTuples = quadTree->getAllOverlappingElementTuples();
-        for(auto overlapingTuple: overlappingTuples){
-            auto element0 = QuadTreeElement<int>::dynamicCast<MyCustomElement>(std::get<0>(overlapingTuple));
-            auto element1 = QuadTreeElement<int>::dynamicCast<MyCustomElement>(std::get<1>(overlapingTuple));
-            int width0 =  element0->aabb.xMax - element0->aabb.xMin;
-            int height0 = element0->aabb.yMax - element0->aabb.yMin;
-            int width1 =  element1->aabb.xMax - element1->aabb.xMin;
-            int height1 = element1->aabb.yMax - element1->aabb.yMin;
-            int x0Ctr = element0->aabb.xMin + width0 /2;
-            int y0Ctr = element0->aabb.yMin + height0/2;
-            int x1Ctr = element1->aabb.xMin + width1 /2;
-            int y1Ctr = element1->aabb.yMin + height1/2;
-            int xOverlap = abs(abs(x0Ctr-x1Ctr) - (width0+width1)/2);
-            int yOverlap = abs(abs(y0Ctr-y1Ctr) - (height0+height1)/2);
-            if(xOverlap < yOverlap){
-                if(x0Ctr < x1Ctr){
-                    element0->direction.setX(-abs(element0->direction.x()));
-                    element1->direction.setX( abs(element1->direction.x()));
-                }else{
-                    element0->direction.setX( abs(element0->direction.x()));
-                    element1->direction.setX(-abs(element1->direction.x()));
-                }
-            }else{
-                if(y0Ctr < y1Ctr){
-                    element0->direction.setY(-abs(element0->direction.y()));
-                    element1->direction.setY( abs(element1->direction.y()));
-                }else{
-                    element0->direction.setY( abs(element0->direction.y()));
-                    element1->direction.setY(-abs(element1->direction.y()));
-                }
-            }
-
+        for(auto &overlapingTuple: overlappingTuples){
+            auto element0 = static_cast<MyCustomElement*>(std::get<0>(overlapingTuple));
+            auto element1 = static_cast<MyCustomElement*>(std::get<1>(overlapingTuple));
+            state.resolveCollision(element0->id,element0->aabb,element1->aabb,true);
+            state.resolveCollision(element1->id,element0->aabb,element1->aabb,false);
         }
-        for(auto element: elementsPtrs){
-
-            if(element->aabb.xMin < boundingBox.xMin){
-                element->direction.setX(abs(element->direction.x()));
+        state.integrate(elementsPtrs,boundingBox,0,elementsPtrs.size());
+    }
+    /*
+     * Every element resolves its own pairs, so threads never write the same element and pairs don't have to be colored.
+     * Pairs are bucketed by element with counting sort: pairs of every element are counted, counts are turned into offsets
+     * and every pair is written to buckets of both its elements. Buckets are sorted by pair index, so every element
+     * sees its pairs in the same order as in updateSerial and result doesn't depend on threads number
+     */
+    void updateParallel(){
+        auto overlappingTuples = quadTree->getAllOverlappingElementTuples();
+        int elementsNumber = elementsPtrs.size();
+        int pairsNumber = overlappingTuples.size();
+        if(pairsCounts.size() != elementsNumber){
+            pairsCounts = vector<std::atomic<int>>(elementsNumber);
+        }
+        pairsOffsets.resize(elementsNumber+1);
+        pairsElements.resize(pairsNumber);
+        elementsPairs.resize(2*pairsNumber);
+        threadsPool->parallelFor(0,elementsNumber,[&](int begin, int end){
+            for(int i=begin;i<end;i++){
+                pairsCounts[i].store(0,std::memory_order_relaxed);
             }
-            if(element->aabb.xMax > boundingBox.xMax){
-                element->direction.setX(-abs(element->direction.x()));
+        },parallelMinChunkSize);
+        threadsPool->parallelFor(0,pairsNumber,[&](int begin, int end){
+            for(int i=begin;i<end;i++){
+                int elementId0 = static_cast<MyCustomElement*>(std::get<0>(overlappingTuples[i]))->id;
+                int elementId1 = static_cast<MyCustomElement*>(std::get<1>(overlappingTuples[i]))->id;
+                pairsElements[i] = std::make_pair(elementId0,elementId1);
+                pairsCounts[elementId0].fetch_add(1,std::memory_order_relaxed);
+                pairsCounts[elementId1].fetch_add(1,std::memory_order_relaxed);
             }
-            if(element->aabb.yMin < boundingBox.yMin){
-                element->direction.setY(abs(element->direction.y()));
+        },parallelMinChunkSize);
+        //Counts become write positions of buckets
+        int offset = 0;
+        for(int i=0;i<elementsNumber;i++){
+            pairsOffsets[i] = offset;
+            offset += pairsCounts[i].exchange(offset,std::memory_order_relaxed);
+        }
+        pairsOffsets[elementsNumber] = offset;
+        threadsPool->parallelFor(0,pairsNumber,[&](int begin, int end){
+            for(int i=begin;i<end;i++){
+                elementsPairs[pairsCounts[pairsElements[i].first].fetch_add(1,std::memory_order_relaxed)] = i;
+                elementsPairs[pairsCounts[pairsElements[i].second].fetch_add(1,std::memory_order_relaxed)] = i;
             }
-            if(element->aabb.yMax > boundingBox.yMax){
-                element->direction.setY(-abs(element->direction.y()));
+        },parallelMinChunkSize);
+        threadsPool->parallelFor(0,elementsNumber,[&](int begin, int end){
+            for(int i=begin;i<end;i++){
+                auto bucketBegin = elementsPairs.begin() + pairsOffsets[i];
+                auto bucketEnd = elementsPairs.begin() + pairsOffsets[i+1];
+                std::sort(bucketBegin,bucketEnd);
+                for(auto pairIt=bucketBegin;pairIt!=bucketEnd;++pairIt){
+                    const std::pair<int,int> &pair = pairsElements[*pairIt];
+                    state.resolveCollision(i,elementsPtrs[pair.first]->aabb,elementsPtrs[pair.second]->aabb,pair.first == i);
+                }
             }
-            element->update();
-        }
+        },parallelMinChunkSize);
+        //Boxes are moved only after all pairs are resolved, because resolving reads boxes of other elements
+        threadsPool->parallelFor(0,elementsNumber,[&](int begin, int end){
+            state.integrate(elementsPtrs,boundingBox,begin,end);
+        },parallelMinChunkSize);
+    }
+    //Worker threads are started here and kept until threads number changes
+    void setThreadsNumber(int threadsNumber){
+        threadsNumber = std::max(1,threadsNumber);
+        if(threadsNumber == getThreadsNumber()) return;
+        threadsPool.reset(threadsNumber > 1 ? new ParallelForPool(threadsNumber) : nullptr);
+    }
+    int getThreadsNumber() const{
+        return threadsPool ? threadsPool->getThreadsNumber() : 1;
     }
 
+    //Elements are only appended between resets, so elementsPtrs follows memory order of the pool
+    QuadTreeElementPool<MyCustomElement> elementsPool;
     vector<MyCustomElement::Type> elementsPtrs;
+    MyCustomElementsState state;
+    unique_ptr<ParallelForPool> threadsPool;
+    int parallelMinElementsNumber = 20000;
+    int parallelMinChunkSize = 4096;
+    //Buckets of pairs built by updateParallel, kept between frames to reuse memory
+    vector<std::atomic<int>> pairsCounts;
+    vector<int> pairsOffsets;
+    vector<std::pair<int,int>> pairsElements;
+    vector<int> elementsPairs;
     unique_ptr<QuadTree<int>> quadTree;
     const QuadTreeVisualionHelper<int> *visualisationHelper;
     AABB<int> boundingBox{0,0,799,799};
+    int treeDepth = 6;
+    int treeNodeCapacity = 4;
+
+protected:
+    void pushElement(const AABB<int> &aabb, QColor color=Qt::yellow){
+        MyCustomElement *element = elementsPool.make(aabb,color);
+        element->id = elementsPtrs.size();
+        elementsPtrs.push_back(element);
+        state.add(aabb);
+    }
 };
 
+/*
+ * Times frames of holder with numberOfElements random boxes for every threads number, same as simulation thread does:
+ * update followed by tree rebuild. Every run starts with the same boxes and directions
+ */
+inline void benchmarkElementsHolder(int numberOfFrames,
+                                    int numberOfElements,
+                                    const vector<int> &threadsNumbers,
+                                    int treeDepth,
+                                    const AABB<int> &boundingBox,
+                                    int minSize = 2,
+                                    int maxSize = 6)
+{
+    std::cout<<"Performing elements holder test with "<<numberOfElements<<" elements for "<<numberOfFrames<<" frames..."<<std::endl;
+    vector<AABB<int>> aabbs(numberOfElements);
+    for(auto &aabb: aabbs){
+        int x = boundingBox.xMin + rand()%(boundingBox.xMax - boundingBox.xMin - maxSize);
+        int y = boundingBox.yMin + rand()%(boundingBox.yMax - boundingBox.yMin - maxSize);
+        aabb = AABB<int>(x,y,x+minSize+rand()%(maxSize-minSize+1),y+minSize+rand()%(maxSize-minSize+1));
+    }
+    int seed = rand();
+    for(int threadsNumber: threadsNumbers){
+        srand(seed);
+        MyCustomElementsHolder holder;
+        holder.setThreadsNumber(threadsNumber);
+        holder.boundingBox = boundingBox;
+        holder.treeDepth = treeDepth;
+        holder.addElements(aabbs);
+        std::chrono::high_resolution_clock::duration updateDuration(0), rebuildDuration(0);
+        for(int i=0;i<numberOfFrames;i++){
+            std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+            holder.update();
+            std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+            holder.addElements({});
+            std::chrono::high_resolution_clock::time_point t3 = std::chrono::high_resolution_clock::now();
+            updateDuration += t2 - t1;
+            rebuildDuration += t3 - t2;
+        }
+        std::cout<<"Threads: "<<threadsNumber<<
+                   ", update took "<<std::chrono::duration_cast<std::chrono::microseconds>(updateDuration).count()<<" microseconds"<<
+                   ", tree rebuild took "<<std::chrono::duration_cast<std::chrono::microseconds>(rebuildDuration).count()<<" microseconds"<<std::endl;
+    }
+}
+
+/*
+ * Runs MyCustomElementsHolder on worker thread with fixed time step and publishes frame snapshots,
+ * so simulation rate doesn't depend on how often widget is painted.
+ * Holder is touched only by worker thread, requests from other threads are queued and applied before next step
+ */
+class QuadTreeSimulation{
+public:
+    QuadTreeSimulation(int stepIntervalMs=30):stepIntervalMs(stepIntervalMs){}
+    ~QuadTreeSimulation(){
+        stop();
+    }
+    void start(){
+        if(running.exchange(true)) return;
+        worker = std::thread([this](){ run(); });
+    }
+    void stop(){
+        if(!running.exchange(false)) return;
+        worker.join();
+        //Worker is gone, so remaining commands can be applied here. Otherwise trees passed to setQuadTree would leak
+        applyCommands();
+    }
+    void setPaused(bool paused){
+        this->paused = paused;
+    }
+    bool isPaused() const{
+        return paused;
+    }
+    void addElements(const vector<AABB<int>> &aabbs){
+        enqueue([aabbs](MyCustomElementsHolder &holder){
+            holder.addElements(aabbs);
+        });
+    }
+    void setElements(const vector<AABB<int>> &aabbs, const AABB<int> &boundingBox){
+        enqueue([aabbs,boundingBox](MyCustomElementsHolder &holder){
+            holder.reset();
+            holder.boundingBox = boundingBox;
+            holder.addElements(aabbs);
+        });
+    }
+    void setBoundingBox(const AABB<int> &boundingBox){
+        enqueue([boundingBox](MyCustomElementsHolder &holder){
+            holder.boundingBox = boundingBox;
+        });
+    }
+    void reset(){
+        enqueue([](MyCustomElementsHolder &holder){
+            holder.reset();
+        });
+    }
+    //Simulation takes ownership of given tree
+    void setQuadTree(QuadTree<int>* quadTree){
+        enqueue([quadTree](MyCustomElementsHolder &holder){
+            holder.setQuadTree(quadTree);
+        });
+    }
+    void setThreadsNumber(int threadsNumber){
+        enqueue([threadsNumber](MyCustomElementsHolder &holder){
+            holder.setThreadsNumber(threadsNumber);
+        });
+    }
+    //Reader side of snapshot buffer, must always be called from the same thread
+    const QuadTreeFrameSnapshot &getLatestSnapshot(){
+        return snapshots.getReadBuffer();
+    }
+
+protected:
+    void enqueue(std::function<void(MyCustomElementsHolder&)> command){
+        std::lock_guard<std::mutex> lock(commandsMutex);
+        commands.push_back(command);
+    }
+    void applyCommands(){
+        vector<std::function<void(MyCustomElementsHolder&)>> currentCommands;
+        {
+            std::lock_guard<std::mutex> lock(commandsMutex);
+            std::swap(currentCommands,commands);
+        }
+        for(auto &command: currentCommands){
+            command(holder);
+        }
+    }
+    void run(){
+        auto nextStepTime = std::chrono::steady_clock::now();
+        while(running){
+            applyCommands();
+            holder.quadTree->resetQueryStats();
+            if(!paused){
+                holder.update();
+                holder.addElements({});
+            }
+            publishSnapshot();
+            nextStepTime += std::chrono::milliseconds(stepIntervalMs);
+            auto now = std::chrono::steady_clock::now();
+            //Don't try to catch up if step took longer than its interval
+            if(nextStepTime < now) nextStepTime = now;
+            std::this_thread::sleep_until(nextStepTime);
+        }
+    }
+    void publishSnapshot(){
+        QuadTreeFrameSnapshot &snapshot = snapshots.getWriteBuffer();
+        auto overlappingObjects = holder.getOverlappingObjects();
+        std::unordered_set<QuadTreeElement<int>::Type> overlappingSet(overlappingObjects.begin(),overlappingObjects.end());
+        snapshot.boxes.resize(holder.elementsPtrs.size());
+        snapshot.overlapping.resize(holder.elementsPtrs.size());
+        for(int i=0;i<holder.elementsPtrs.size();i++){
+            snapshot.boxes.at(i) = holder.elementsPtrs.at(i)->aabb;
+            snapshot.overlapping.at(i) = overlappingSet.count(holder.elementsPtrs.at(i));
+        }
+        snapshot.nodeBoxes = holder.visualisationHelper->getNonLeafNodesBoundingBoxes();
+        snapshot.nodesSplitAtCenter = holder.visualisationHelper->areNodesSplitAtCenter();
+        snapshot.queryStats = holder.quadTree->getQueryStats();
+        snapshots.publish();
+    }
+
+    MyCustomElementsHolder holder;
+    int stepIntervalMs;
+    std::atomic<bool> running{false};
+    std::atomic<bool> paused{false};
+    std::thread worker;
+    std::mutex commandsMutex;
+    vector<std::function<void(MyCustomElementsHolder&)>> commands;
+    SnapshotBuffer<QuadTreeFrameSnapshot> snapshots;
+};
+
+//Draws snapshot published by QuadTreeSimulation, shared by quad tree widgets
+inline void drawQuadTreeFrameSnapshot(QPainter &painter, const QuadTreeFrameSnapshot &snapshot){
+    //Draw tree
+    painter.setBrush(Qt::NoBrush);
+    for(auto &boundingBox: snapshot.nodeBoxes){
+        if(!snapshot.nodesSplitAtCenter){
+            painter.drawRect(boundingBox.xMin,boundingBox.yMin,boundingBox.xMax - boundingBox.xMin,boundingBox.yMax - boundingBox.yMin);
+            continue;
+        }
+        int xCtr = boundingBox.xMin + (boundingBox.xMax - boundingBox.xMin)/2;
+        int yCtr = boundingBox.yMin + (boundingBox.yMax - boundingBox.yMin)/2;
+        painter.drawLine(boundingBox.xMin,yCtr,boundingBox.xMax,yCtr);
+        painter.drawLine(xCtr,boundingBox.yMin,xCtr,boundingBox.yMax);
+    }
+
+    //Draw boxes, colliding ones are highlighted
+    for(int i=0;i<snapshot.boxes.size();i++){
+        auto &aabb = snapshot.boxes.at(i);
+        painter.setBrush(QBrush(snapshot.overlapping.at(i) ? Qt::red : Qt::cyan));
+        painter.drawRect(aabb.xMin,aabb.yMin,aabb.xMax - aabb.xMin,aabb.yMax - aabb.yMin);
+    }
+
+    if(QUAD_TREE_QUERY_COUNTERS){
+        const QuadTreeQueryStats &stats = snapshot.queryStats;
+        painter.setPen(Qt::black);
+        painter.drawText(10,20,QString("Nodes visited: ") + QString::number(stats.nodesVisited) +
+                         QString(", leaves visited: ") + QString::number(stats.leavesVisited));
+        painter.drawText(10,40,QString("Pairs tested: ") + QString::number(stats.candidatePairs) +
+                         QString(", emitted: ") + QString::number(stats.emittedPairs) +
+                         QString(" (") + QString::number(stats.ancestorPairs) + QString(" without test)"));
+    }
+}
+
 class QTreeVisualisationWidget: public QWidget
 {
     Q_OBJECT
@@ -153,78 +474,41 @@ public:
         connect(&timer,SIGNAL(timeout()),this,SLOT(update()));
         timer.start(updateIntervalMs);
         srand( time( 0 ) );
+        simulation.start();
     }
     void setPoints(vector<QPoint> points){
-        holder.reset();
-        holder.boundingBox = AABB<int>(0,0,this->width(),this->height());
-        holder.addElements(pointsToElements(points));
+        simulation.setElements(pointsToElements(points),AABB<int>(0,0,this->width(),this->height()));
         this->update();
     }
 public slots:
     void reset(){
-        points.clear();
-        holder.reset();
+        simulation.reset();
 //        this->update();
     }
 protected:
     virtual void mousePressEvent(QMouseEvent *mouseEvent) override{
-        bool callUpdate = false;
         std::cout<<mouseEvent->pos().x()<<" "<<mouseEvent->pos().y()<<std::endl;
         if(mouseEvent->buttons() == Qt::RightButton){
             if(timer.isActive()){
                 timer.stop();
+                simulation.setPaused(true);
             }else{
                 timer.start(updateIntervalMs);
+                simulation.setPaused(false);
             }
-            callUpdate = true;
         }else if(mouseEvent->buttons() == Qt::LeftButton){
-            points.push_back(mouseEvent->pos());
-            this->sendPointsToQTree();
-            callUpdate = true;
+            vector<QPoint> points{mouseEvent->pos()};
+            simulation.addElements(pointsToElements(points));
         }
-//        if(callUpdate) this->update();
     }
+    virtual void resizeEvent(QResizeEvent *event) override{
+        simulation.setBoundingBox(AABB<int>(0,0,this->width(),this->height()));
+        QWidget::resizeEvent(event);
+    }
+    //Only draws the latest frame, simulation itself runs on its own thread
     virtual void paintEvent(QPaintEvent *event) override{
         QPainter painter(this);
-        sendPointsToQTree();
-
-        //Draw tree
-        for(auto &boundingBox: holder.visualisationHelper->getNonLeafNodesBoundingBoxes()){
-            int xCtr = boundingBox.xMin + (boundingBox.xMax - boundingBox.xMin)/2;
-            int yCtr = boundingBox.yMin + (boundingBox.yMax - boundingBox.yMin)/2;
-            painter.drawLine(boundingBox.xMin,yCtr,boundingBox.xMax,yCtr);
-            painter.drawLine(xCtr,boundingBox.yMin,xCtr,boundingBox.yMax);
-
-        }
-
-        //Draw boxes
-        for(auto element: holder.elementsPtrs){
-            painter.setBrush(QBrush(Qt::cyan));
-            int width = element->aabb.xMax - element->aabb.xMin;
-            int height = element->aabb.yMax - element->aabb.yMin;
-            painter.drawRect(element->aabb.xMin,element->aabb.yMin,width,height);
-        }
-//        for(QPoint point: points){
-//            painter.setBrush(QBrush(Qt::yellow));
-//            painter.drawRect(point.x(),point.y(),quadSide,quadSide);
-//        }
-
-        //Highlight colliding boxes
-        auto overlappingObjects = holder.getOverlappingObjects();
-        for(auto overlappingObject: overlappingObjects){
-            painter.setBrush(QBrush(Qt::red));
-            int width = overlappingObject->aabb.xMax - overlappingObject->aabb.xMin;
-            int height = overlappingObject->aabb.yMax - overlappingObject->aabb.yMin;
-            painter.drawRect(overlappingObject->aabb.xMin,overlappingObject->aabb.yMin,width,height);
-        }
-
-    }
-    void sendPointsToQTree(){
-        holder.update();
-        holder.boundingBox = AABB<int>(0,0,this->width(),this->height());
-        holder.addElements(pointsToElements(points));
-        points.clear();
-//        update();
+        drawQuadTreeFrameSnapshot(painter,simulation.getLatestSnapshot());
     }
     vector<AABB<int>> pointsToElements(vector<QPoint> &points){
         vector<AABB<int>> elements;
@@ -236,9 +520,7 @@ protected:
         return  elements;
     }
 
-    MyCustomElementsHolder holder;
-    int quadSide = 5;
-    vector<QPoint> points;
+    QuadTreeSimulation simulation;
     QTimer timer{this};
     int updateIntervalMs = 30;
 };
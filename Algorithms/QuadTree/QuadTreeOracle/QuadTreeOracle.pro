@@ -0,0 +1,12 @@
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= app_bundle
+CONFIG += thread
+CONFIG -= qt
+
+TARGET = QuadTreeOracle
+
+INCLUDEPATH += ../QuadTree
+
+SOURCES += \
+        main.cpp
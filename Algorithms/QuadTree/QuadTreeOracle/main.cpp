@@ -0,0 +1,47 @@
+#include <cstdlib>
+#include <ctime>
+
+#include "quad_tree_oracle.h"
+#include "quad_tree_slow.h"
+#include "quad_tree_moderate.h"
+#include "quad_tree_fast.h"
+#include "quad_tree_str.h"
+#include "quad_tree_dynamic.h"
+
+using namespace std;
+
+template <class T>
+int runOracle(unsigned int seed, int numberOfRepetitions){
+    vector<typename QuadTreeOracle<T>::NAMED_QUAD_TREE> quadTrees{
+        {"QuadTreeSlow", new QuadTreeSlow<T>()},
+        {"QuadTreeModerate", new QuadTreeModerate<T>()},
+        {"QuadTreeFast", new QuadTreeFast<T>()},
+        {"STRTree(4)", new STRTree<T>(4)},
+        {"STRTree(16)", new STRTree<T>(16)},
+        {"DynamicAABBTree", new DynamicAABBTree<T>()}};
+    vector<QuadTreeOracleScene<T>> scenes{
+        {QUAD_TREE_ORACLE_SCENE_TYPE::UNIFORM,   1000,  AABB<T>(0,0,1024,1024), 4, 40, 6,  6},
+        {QUAD_TREE_ORACLE_SCENE_TYPE::UNIFORM,   10000, AABB<T>(0,0,4000,4000), 4, 64, 8,  8},
+        {QUAD_TREE_ORACLE_SCENE_TYPE::CLUSTERED, 3000,  AABB<T>(0,0,2048,2048), 2, 20, 10, 4},
+        {QUAD_TREE_ORACLE_SCENE_TYPE::GRID,      2000,  AABB<T>(0,0,1000,1000), 20, 20, 6, 6}};
+    int mismatchesNumber = QuadTreeOracle<T>(seed).run(quadTrees,scenes,numberOfRepetitions);
+    for(auto &namedQuadTree: quadTrees){
+        delete namedQuadTree.second;
+    }
+    return mismatchesNumber;
+}
+
+//Usage: QuadTreeOracle [seed] [repetitions], returns nonzero if any backend disagrees with brute force
+int main(int argc, char *argv[])
+{
+    unsigned int seed = argc > 1 ? strtoul(argv[1],nullptr,10) : time(0);
+    int numberOfRepetitions = argc > 2 ? atoi(argv[2]) : 3;
+    cout<<"Seed "<<seed<<", "<<numberOfRepetitions<<" repetitions"<<endl;
+    cout<<"int:"<<endl;
+    int mismatchesNumber = runOracle<int>(seed,numberOfRepetitions);
+    cout<<"double:"<<endl;
+    mismatchesNumber += runOracle<double>(seed,numberOfRepetitions);
+    cout<<(mismatchesNumber == 0 ? "All backends match brute force" : "Backends don't match brute force: ")<<
+          (mismatchesNumber == 0 ? "" : to_string(mismatchesNumber))<<endl;
+    return mismatchesNumber == 0 ? 0 : 1;
+}
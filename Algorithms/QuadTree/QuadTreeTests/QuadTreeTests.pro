@@ -9,7 +9,12 @@ QMAKE_CXXFLAGS += -save-temps
 
 HEADERS += \
     aabb_test.h \
-    quad_tree_test.h
+    quad_tree_test.h \
+    str_tree_test.h \
+    dynamic_tree_test.h \
+    pair_manager_test.h \
+    orthant_tree_test.h \
+    element_pool_test.h
 
 SOURCES += \
         main.cpp
@@ -62,3 +62,30 @@ TEST(AABB, equalsOperator){
 
     EXPECT_FALSE(aabb0 == aabb2);
 }
+TEST(QuantizedAABB, coversOriginal){
+    AABB<double> reference(-10,-10,30,50);
+    AABB<double> aabb(-3.3,0.1,7.7,49.9);
+    QuantizedAABB<uint8_t> quantized(aabb,reference);
+    EXPECT_LE(-10 + quantized.xMin * 40.0/255, aabb.xMin);
+    EXPECT_LE(-10 + quantized.yMin * 60.0/255, aabb.yMin);
+    EXPECT_GE(-10 + quantized.xMax * 40.0/255, aabb.xMax);
+    EXPECT_GE(-10 + quantized.yMax * 60.0/255, aabb.yMax);
+}
+TEST(QuantizedAABB, mayOverlap){
+    AABB<int> reference(0,0,1000,1000);
+    std::vector<AABB<int>> aabbs;
+    for(int i=0;i<1000;i++){
+        int x = rand()%990;
+        int y = rand()%990;
+        aabbs.push_back(AABB<int>(x,y,x+1+rand()%10,y+1+rand()%10));
+    }
+    for(int i=0;i<aabbs.size();i++){
+        for(int j=i+1;j<aabbs.size();j++){
+            if(aabbs.at(i).doesOverlap(aabbs.at(j))){
+                EXPECT_TRUE(QuantizedAABB<uint8_t>(aabbs.at(i),reference).mayOverlap(QuantizedAABB<uint8_t>(aabbs.at(j),reference)));
+                EXPECT_TRUE(QuantizedAABB<uint16_t>(aabbs.at(i),reference).mayOverlap(QuantizedAABB<uint16_t>(aabbs.at(j),reference)));
+            }
+        }
+    }
+    EXPECT_FALSE(QuantizedAABB<uint16_t>(AABB<int>(0,0,10,10),reference).mayOverlap(QuantizedAABB<uint16_t>(AABB<int>(20,20,30,30),reference)));
+}
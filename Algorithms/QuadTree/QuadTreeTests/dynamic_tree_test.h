@@ -0,0 +1,105 @@
+#ifndef DYNAMIC_TREE_TEST_H
+#define DYNAMIC_TREE_TEST_H
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+#include <set>
+#include <cmath>
+
+#include "../QuadTree/quad_tree.h"
+#include "../QuadTree/quad_tree_dynamic.h"
+
+template <typename T>
+class DynamicAABBTreeTest : public ::testing::Test {};
+using DynamicAABBTreeTypes = ::testing::Types<int,double>;
+TYPED_TEST_SUITE(DynamicAABBTreeTest, DynamicAABBTreeTypes);
+
+template <typename T>
+std::set<std::pair<QuadTreeElement<T>*,QuadTreeElement<T>*>> toOrderedPairs(const vector<tuple<QuadTreeElement<T>*,QuadTreeElement<T>*>> &tuples){
+    std::set<std::pair<QuadTreeElement<T>*,QuadTreeElement<T>*>> pairs;
+    for(auto &tuple: tuples){
+        auto a = std::get<0>(tuple);
+        auto b = std::get<1>(tuple);
+        pairs.insert(a < b ? std::make_pair(a,b) : std::make_pair(b,a));
+    }
+    return pairs;
+}
+
+template <typename T>
+std::set<std::pair<QuadTreeElement<T>*,QuadTreeElement<T>*>> getOverlappingPairsBruteForce(const std::vector<QuadTreeElement<T>*> &elements){
+    std::set<std::pair<QuadTreeElement<T>*,QuadTreeElement<T>*>> pairs;
+    for(int i=0;i<elements.size();i++){
+        for(int j=i+1;j<elements.size();j++){
+            if(elements.at(i)->doesOverlap(*elements.at(j))){
+                auto a = elements.at(i);
+                auto b = elements.at(j);
+                pairs.insert(a < b ? std::make_pair(a,b) : std::make_pair(b,a));
+            }
+        }
+    }
+    return pairs;
+}
+
+TYPED_TEST(DynamicAABBTreeTest, setElements0Arg){
+    using EL = QuadTreeElement<TypeParam>;
+    std::vector<EL*> vec0EL;
+    DynamicAABBTree<TypeParam> tree;
+    tree.setElements(vec0EL, AABB<TypeParam>(0,0,100,100));
+    EXPECT_TRUE(tree.getAllOverlappingElements().size()==0);
+    EXPECT_TRUE(tree.getAllOverlappingElementTuples().size()==0);
+    EXPECT_EQ(tree.getHeight(),0);
+}
+
+TYPED_TEST(DynamicAABBTreeTest, updateProxy){
+    using EL = QuadTreeElement<TypeParam>;
+    EL element0(AABB<TypeParam>(0,0,10,10));
+    EL element1(AABB<TypeParam>(30,30,40,40));
+    DynamicAABBTree<TypeParam> tree(5);
+    int proxyId0 = tree.insertProxy(&element0);
+    tree.insertProxy(&element1);
+    tree.updatePairs();
+    EXPECT_EQ(tree.getAllOverlappingElementTuples().size(),0);
+
+    element0.aabb.translateBy(3,3);
+    EXPECT_FALSE(tree.updateProxy(proxyId0));
+    element0.aabb.translateBy(20,20);
+    EXPECT_TRUE(tree.updateProxy(proxyId0));
+    tree.updatePairs();
+    EXPECT_EQ(tree.getAllOverlappingElementTuples().size(),1);
+
+    tree.removeProxy(proxyId0);
+    tree.updatePairs();
+    EXPECT_EQ(tree.getAllOverlappingElementTuples().size(),0);
+    EXPECT_EQ(tree.getStats().leavesNumber,1);
+}
+
+TYPED_TEST(DynamicAABBTreeTest, matchesBruteForceWhileMoving){
+    using EL = QuadTreeElement<TypeParam>;
+    std::vector<EL> vecEL;
+    for(int i=0;i<400;i++){
+        TypeParam x = rand()%950;
+        TypeParam y = rand()%950;
+        vecEL.push_back(EL(AABB<TypeParam>(x,y,x+1+rand()%30,y+1+rand()%30)));
+    }
+    std::vector<EL*> vecELptrs;
+    for(auto &el: vecEL){
+        vecELptrs.push_back(&el);
+    }
+    DynamicAABBTree<TypeParam> tree;
+    for(int frame=0;frame<20;frame++){
+        for(auto &el: vecEL){
+            el.aabb.translateBy(rand()%7-3,rand()%7-3);
+        }
+        //Elements are removed and added back over frames
+        std::vector<EL*> frameElementsPtrs(vecELptrs.begin()+frame,vecELptrs.end());
+        tree.setElements(frameElementsPtrs, AABB<TypeParam>(0,0,1000,1000));
+        auto tuples = tree.getAllOverlappingElementTuples();
+        auto expectedPairs = getOverlappingPairsBruteForce<TypeParam>(frameElementsPtrs);
+        EXPECT_EQ(tuples.size(),expectedPairs.size());
+        EXPECT_TRUE(toOrderedPairs<TypeParam>(tuples) == expectedPairs);
+        EXPECT_EQ(tree.getStats().leavesNumber,frameElementsPtrs.size());
+    }
+    EXPECT_LE(tree.getHeight(),2*std::log2(vecEL.size())+1);
+    EXPECT_EQ(tree.getElementsThatOverlap(AABB<TypeParam>(-10000,-10000,10000,10000)).size(),vecEL.size()-19);
+}
+
+#endif // DYNAMIC_TREE_TEST_H
@@ -0,0 +1,94 @@
+#ifndef ELEMENT_POOL_TEST_H
+#define ELEMENT_POOL_TEST_H
+#include <random>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+#include "../QuadTree/quad_tree.h"
+#include "../QuadTree/quad_tree_element_pool.h"
+
+struct CountedElement: public QuadTreeElement<int>{
+    CountedElement(const AABB<int> &aabb, int &aliveNumber):QuadTreeElement<int>(aabb),aliveNumber(aliveNumber){
+        aliveNumber++;
+    }
+    virtual ~CountedElement(){
+        aliveNumber--;
+    }
+    int &aliveNumber;
+};
+
+TEST(ElementPoolTest, elementsAreContiguousInMemoryOrder){
+    QuadTreeElementPool<QuadTreeElement<int>,4> pool;
+    vector<QuadTreeElement<int>*> made;
+    for(int i=0;i<10;i++){
+        made.push_back(pool.make(AABB<int>(i,i,i+1,i+1)));
+    }
+    EXPECT_EQ(pool.size(),10);
+    EXPECT_EQ(pool.getChunksNumber(),3);
+    EXPECT_EQ(made.at(1),made.at(0)+1);
+    EXPECT_EQ(made.at(3),made.at(0)+3);
+    EXPECT_EQ(pool.getElements(),made);
+}
+
+TEST(ElementPoolTest, destroyedSlotIsReused){
+    QuadTreeElementPool<QuadTreeElement<int>,4> pool;
+    vector<QuadTreeElement<int>*> made;
+    for(int i=0;i<6;i++){
+        made.push_back(pool.make(AABB<int>(i,i,i+1,i+1)));
+    }
+    pool.destroy(made.at(2));
+    EXPECT_EQ(pool.size(),5);
+    auto elements = pool.getElements();
+    EXPECT_EQ(std::find(elements.begin(),elements.end(),made.at(2)),elements.end());
+
+    QuadTreeElement<int>* element = pool.make(AABB<int>(7,7,8,8));
+    EXPECT_EQ(element,made.at(2));
+    EXPECT_EQ(pool.getChunksNumber(),2);
+    EXPECT_TRUE(pool.getElements().at(2)->aabb == AABB<int>(7,7,8,8));
+}
+
+TEST(ElementPoolTest, destroyFindsOwnerAmongManyChunks){
+    QuadTreeElementPool<QuadTreeElement<int>,4> pool;
+    vector<QuadTreeElement<int>*> made;
+    for(int i=0;i<100;i++){
+        made.push_back(pool.make(AABB<int>(i,i,i+1,i+1)));
+    }
+    std::shuffle(made.begin(),made.end(),std::mt19937(5));
+    for(int i=0;i<50;i++){
+        pool.destroy(made.at(i));
+    }
+    EXPECT_EQ(pool.size(),50);
+    auto elements = pool.getElements();
+    std::sort(elements.begin(),elements.end());
+    vector<QuadTreeElement<int>*> expectedElements(made.begin()+50,made.end());
+    std::sort(expectedElements.begin(),expectedElements.end());
+    EXPECT_EQ(elements,expectedElements);
+    for(int i=0;i<50;i++){
+        pool.make(AABB<int>(i,i,i+1,i+1));
+    }
+    EXPECT_EQ(pool.getChunksNumber(),25);
+}
+
+TEST(ElementPoolTest, resetDestroysEverything){
+    int aliveNumber = 0;
+    {
+        QuadTreeElementPool<CountedElement,8> pool;
+        for(int i=0;i<20;i++){
+            pool.make(AABB<int>(i,i,i+1,i+1),aliveNumber);
+        }
+        pool.destroy(pool.getElements().at(5));
+        EXPECT_EQ(aliveNumber,19);
+        pool.reset();
+        EXPECT_EQ(aliveNumber,0);
+        EXPECT_EQ(pool.size(),0);
+        EXPECT_EQ(pool.getChunksNumber(),0);
+        for(int i=0;i<3;i++){
+            pool.make(AABB<int>(i,i,i+1,i+1),aliveNumber);
+        }
+        EXPECT_EQ(aliveNumber,3);
+    }
+    EXPECT_EQ(aliveNumber,0);
+}
+
+#endif // ELEMENT_POOL_TEST_H
@@ -2,6 +2,11 @@
 
 #include "aabb_test.h"
 #include "quad_tree_test.h"
+#include "str_tree_test.h"
+#include "dynamic_tree_test.h"
+#include "pair_manager_test.h"
+#include "orthant_tree_test.h"
+#include "element_pool_test.h"
 
 int main(int argc, char *argv[])
 {
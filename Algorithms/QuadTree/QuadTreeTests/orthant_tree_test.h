@@ -0,0 +1,144 @@
+#ifndef ORTHANT_TREE_TEST_H
+#define ORTHANT_TREE_TEST_H
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+#include <set>
+
+#include "../QuadTree/quad_tree.h"
+#include "../QuadTree/quad_tree_fast.h"
+#include "../QuadTree/quad_tree_orthant.h"
+
+template <typename T>
+class OrthantTreeTest : public ::testing::Test {};
+using OrthantTreeTypes = ::testing::Types<int, unsigned int,double>;
+TYPED_TEST_SUITE(OrthantTreeTest, OrthantTreeTypes);
+
+TYPED_TEST(OrthantTreeTest, splitMatchesQuadrants){
+    AABB<TypeParam> aabb(0,0,100,100);
+    auto quadrants = aabb.split();
+    auto children = AABBN<TypeParam,2>(aabb).split();
+    for(int i=0;i<4;i++){
+        EXPECT_TRUE((children.at(i) == AABBN<TypeParam,2>(quadrants.at(i))));
+    }
+}
+
+TYPED_TEST(OrthantTreeTest, splitOctants){
+    AABBN<TypeParam,3> aabb({0,0,0},{100,100,100});
+    auto children = aabb.split();
+    EXPECT_TRUE((children.at(0) == AABBN<TypeParam,3>({50,50,50},{100,100,100})));
+    EXPECT_TRUE((children.at(7) == AABBN<TypeParam,3>({0,0,0},{50,50,50})));
+    //Bit 0 is set for lower half of last dimension
+    EXPECT_TRUE((children.at(1) == AABBN<TypeParam,3>({50,50,0},{100,100,50})));
+    for(int i=0;i<8;i++){
+        EXPECT_TRUE(children.at(i).isCompletlyInside(aabb));
+        for(int j=i+1;j<8;j++){
+            EXPECT_FALSE(children.at(i).doesOverlap(children.at(j)));
+        }
+    }
+}
+
+TYPED_TEST(OrthantTreeTest, octreeSetElements2Arg){
+    using EL = OrthantTreeElement<TypeParam,3>;
+    EL element0(AABBN<TypeParam,3>({0,0,0},{10,10,10}));
+    EL element1(AABBN<TypeParam,3>({0,0,5},{11,11,11}));
+    EL element2(AABBN<TypeParam,3>({0,0,20},{11,11,30}));
+    std::vector<EL*> vecELptrs {&element0,&element1,&element2};
+    OctreeFast<TypeParam> tree(vecELptrs, AABBN<TypeParam,3>({0,0,0},{100,100,100}));
+    EXPECT_EQ(tree.getAllOverlappingElements().size(),2);
+    EXPECT_EQ(tree.getAllOverlappingElementTuples().size(),1);
+    EXPECT_EQ(tree.getElementsThatOverlap(AABBN<TypeParam,3>({0,0,25},{1,1,26})).size(),1);
+}
+
+TYPED_TEST(OrthantTreeTest, octreeMatchesBruteForce){
+    using EL = OrthantTreeElement<TypeParam,3>;
+    std::vector<EL> vecEL;
+    for(int i=0;i<1000;i++){
+        TypeParam x = rand()%450;
+        TypeParam y = rand()%450;
+        TypeParam z = rand()%450;
+        vecEL.push_back(EL(AABBN<TypeParam,3>({x,y,z},{x+1+rand()%50,y+1+rand()%50,z+1+rand()%50})));
+    }
+    std::vector<EL*> vecELptrs;
+    for(auto &el: vecEL){
+        vecELptrs.push_back(&el);
+    }
+    auto orderedPair = [](EL* a, EL* b){
+        return a < b ? std::make_pair(a,b) : std::make_pair(b,a);
+    };
+    std::set<std::pair<EL*,EL*>> expectedPairs;
+    std::set<EL*> expectedElements;
+    for(int i=0;i<vecELptrs.size();i++){
+        for(int j=i+1;j<vecELptrs.size();j++){
+            if(vecELptrs.at(i)->doesOverlap(vecELptrs.at(j)->aabb)){
+                expectedPairs.insert(orderedPair(vecELptrs.at(i),vecELptrs.at(j)));
+                expectedElements.insert(vecELptrs.at(i));
+                expectedElements.insert(vecELptrs.at(j));
+            }
+        }
+    }
+    OctreeFast<TypeParam> tree(vecELptrs, AABBN<TypeParam,3>({0,0,0},{500,500,500}), 4, 6);
+    std::set<std::pair<EL*,EL*>> pairs;
+    for(auto &tuple: tree.getAllOverlappingElementTuples()){
+        pairs.insert(orderedPair(std::get<0>(tuple),std::get<1>(tuple)));
+    }
+    auto elements = tree.getAllOverlappingElements();
+    EXPECT_TRUE(pairs == expectedPairs);
+    EXPECT_TRUE(std::set<EL*>(elements.begin(),elements.end()) == expectedElements);
+
+    //Power of two root of integral tree is split with shifts, both trees are descended at once
+    std::vector<EL*> vecELptrsA(vecELptrs.begin(),vecELptrs.begin()+500);
+    std::vector<EL*> vecELptrsB(vecELptrs.begin()+500,vecELptrs.end());
+    OctreeFast<TypeParam> treeA(vecELptrsA, AABBN<TypeParam,3>({0,0,0},{512,512,512}), 4, 6);
+    OctreeFast<TypeParam> treeB(vecELptrsB, AABBN<TypeParam,3>({0,0,0},{500,500,500}), 3, 4);
+    auto dualTuples = treeA.getOverlappingTuples(treeB);
+    std::set<std::pair<EL*,EL*>> dualPairs;
+    for(auto &tuple: dualTuples){
+        dualPairs.insert(std::make_pair(std::get<0>(tuple),std::get<1>(tuple)));
+    }
+    std::set<std::pair<EL*,EL*>> expectedDualPairs;
+    for(auto elementA: vecELptrsA){
+        for(auto elementB: vecELptrsB){
+            if(elementA->doesOverlap(elementB->aabb)) expectedDualPairs.insert(std::make_pair(elementA,elementB));
+        }
+    }
+    EXPECT_EQ(dualTuples.size(),dualPairs.size());
+    EXPECT_TRUE(dualPairs == expectedDualPairs);
+}
+
+//With D=2 orthant tree must build the same tree as QuadTreeFast
+TYPED_TEST(OrthantTreeTest, quadTreeAgreesWithQuadTreeFast){
+    using EL = QuadTreeElement<TypeParam>;
+    using ELN = OrthantTreeElement<TypeParam,2>;
+    std::vector<EL> vecEL;
+    std::vector<ELN> vecELN;
+    for(int i=0;i<1000;i++){
+        TypeParam x = rand()%950;
+        TypeParam y = rand()%950;
+        AABB<TypeParam> aabb(x,y,x+1+rand()%50,y+1+rand()%50);
+        vecEL.push_back(EL(aabb));
+        vecELN.push_back(ELN(AABBN<TypeParam,2>(aabb)));
+    }
+    std::vector<EL*> vecELptrs;
+    std::vector<ELN*> vecELNptrs;
+    for(int i=0;i<vecEL.size();i++){
+        vecELptrs.push_back(&vecEL.at(i));
+        vecELNptrs.push_back(&vecELN.at(i));
+    }
+    QuadTreeFast<TypeParam> quadTree(vecELptrs, AABB<TypeParam>(0,0,1000,1000), 6, 6);
+    OrthantTreeFast<TypeParam,2> orthantTree(vecELNptrs, AABBN<TypeParam,2>({0,0},{1000,1000}), 6, 6);
+
+    auto quadTreeTuples = quadTree.getAllOverlappingElementTuples();
+    auto orthantTreeTuples = orthantTree.getAllOverlappingElementTuples();
+    ASSERT_EQ(quadTreeTuples.size(),orthantTreeTuples.size());
+    for(int i=0;i<quadTreeTuples.size();i++){
+        EXPECT_EQ(std::get<0>(quadTreeTuples.at(i)) - vecELptrs.front(),std::get<0>(orthantTreeTuples.at(i)) - vecELNptrs.front());
+        EXPECT_EQ(std::get<1>(quadTreeTuples.at(i)) - vecELptrs.front(),std::get<1>(orthantTreeTuples.at(i)) - vecELNptrs.front());
+    }
+    QuadTreeStats quadTreeStats = quadTree.getStats();
+    QuadTreeStats orthantTreeStats = orthantTree.getStats();
+    EXPECT_EQ(quadTreeStats.nodesNumber,orthantTreeStats.nodesNumber);
+    EXPECT_EQ(quadTreeStats.leavesNumber,orthantTreeStats.leavesNumber);
+    EXPECT_EQ(quadTreeStats.elementReferencesNumber,orthantTreeStats.elementReferencesNumber);
+}
+
+#endif // ORTHANT_TREE_TEST_H
@@ -0,0 +1,105 @@
+#ifndef PAIR_MANAGER_TEST_H
+#define PAIR_MANAGER_TEST_H
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+#include <set>
+#include <iterator>
+
+#include "../QuadTree/quad_tree.h"
+#include "../QuadTree/quad_tree_fast.h"
+#include "../QuadTree/quad_tree_pair_manager.h"
+
+TEST(QuadTreePairManager, beginAndEndEvents){
+    using EL = QuadTreeElement<int>;
+    EL element0(AABB<int>(0,0,10,10));
+    EL element1(AABB<int>(5,5,15,15));
+    EL element2(AABB<int>(50,50,60,60));
+    std::vector<EL*> elements{&element0,&element1,&element2};
+    int beginEvents = 0;
+    int endEvents = 0;
+    QuadTreePairManager<int> pairManager(
+                [&](EL*, EL*){ beginEvents++; },
+                [&](EL*, EL*){ endEvents++; });
+    QuadTreeFast<int> quadTree(elements,AABB<int>(0,0,100,100),6,1);
+
+    pairManager.update(quadTree);
+    EXPECT_EQ(beginEvents,1);
+    EXPECT_EQ(endEvents,0);
+    EXPECT_EQ(pairManager.getPairsNumber(),1);
+
+    //Persisting pair is not reported again
+    pairManager.update(quadTree);
+    EXPECT_EQ(beginEvents,1);
+    EXPECT_EQ(endEvents,0);
+
+    element2.aabb.translateBy(-45,-45);
+    quadTree.setElements(elements,AABB<int>(0,0,100,100),6,1);
+    pairManager.update(quadTree);
+    EXPECT_EQ(beginEvents,3);
+    EXPECT_EQ(endEvents,0);
+    EXPECT_EQ(pairManager.getPairsNumber(),3);
+
+    element0.aabb.translateBy(80,80);
+    quadTree.setElements(elements,AABB<int>(0,0,100,100),6,1);
+    pairManager.update(quadTree);
+    EXPECT_EQ(beginEvents,3);
+    EXPECT_EQ(endEvents,2);
+    EXPECT_EQ(pairManager.getPairsNumber(),1);
+    auto pairs = pairManager.getPairs();
+    ASSERT_EQ(pairs.size(),1);
+    EXPECT_EQ(std::set<EL*>({pairs.front().first,pairs.front().second}),std::set<EL*>({&element1,&element2}));
+}
+
+TEST(QuadTreePairManager, duplicatesAndOrder){
+    using EL = QuadTreeElement<int>;
+    EL element0(AABB<int>(0,0,10,10));
+    EL element1(AABB<int>(5,5,15,15));
+    int beginEvents = 0;
+    QuadTreePairManager<int> pairManager;
+    pairManager.setOnBegin([&](EL*, EL*){ beginEvents++; });
+    pairManager.update(vector<tuple<EL*,EL*>>{
+                           tuple<EL*,EL*>(&element0,&element1),
+                           tuple<EL*,EL*>(&element1,&element0),
+                           tuple<EL*,EL*>(&element0,&element1)});
+    EXPECT_EQ(beginEvents,1);
+    EXPECT_EQ(pairManager.getPairsNumber(),1);
+    pairManager.reset();
+    EXPECT_EQ(pairManager.getPairsNumber(),0);
+}
+
+//Many pairs appear and disappear, so table is rehashed and erased slots are reused
+TEST(QuadTreePairManager, matchesSetDifference){
+    using EL = QuadTreeElement<int>;
+    std::vector<EL> elements(300);
+    std::set<std::pair<EL*,EL*>> pairs;
+    std::multiset<std::pair<EL*,EL*>> begunPairs, endedPairs;
+    QuadTreePairManager<int> pairManager(
+                [&](EL* element0, EL* element1){ begunPairs.insert(std::make_pair(element0,element1)); },
+                [&](EL* element0, EL* element1){ endedPairs.insert(std::make_pair(element0,element1)); });
+    for(int frame=0;frame<30;frame++){
+        vector<tuple<EL*,EL*>> tuples;
+        std::set<std::pair<EL*,EL*>> newPairs;
+        int pairsNumber = rand()%(frame%10 == 9 ? 10 : 3000);
+        for(int i=0;i<pairsNumber;i++){
+            EL* element0 = &elements.at(rand()%elements.size());
+            EL* element1 = &elements.at(rand()%elements.size());
+            if(element0 == element1) continue;
+            tuples.push_back(tuple<EL*,EL*>(element0,element1));
+            newPairs.insert(std::make_pair(std::min(element0,element1),std::max(element0,element1)));
+        }
+        begunPairs.clear();
+        endedPairs.clear();
+        pairManager.update(tuples);
+        std::multiset<std::pair<EL*,EL*>> expectedBegunPairs, expectedEndedPairs;
+        std::set_difference(newPairs.begin(),newPairs.end(),pairs.begin(),pairs.end(),std::inserter(expectedBegunPairs,expectedBegunPairs.end()));
+        std::set_difference(pairs.begin(),pairs.end(),newPairs.begin(),newPairs.end(),std::inserter(expectedEndedPairs,expectedEndedPairs.end()));
+        EXPECT_EQ(begunPairs,expectedBegunPairs);
+        EXPECT_EQ(endedPairs,expectedEndedPairs);
+        pairs = newPairs;
+        auto managerPairs = pairManager.getPairs();
+        EXPECT_EQ((std::set<std::pair<EL*,EL*>>(managerPairs.begin(),managerPairs.end())),pairs);
+        EXPECT_EQ(pairManager.getPairsNumber(),pairs.size());
+    }
+}
+
+#endif // PAIR_MANAGER_TEST_H
@@ -5,6 +5,11 @@
 
 #include "../QuadTree/quad_tree.h"
 #include "../QuadTree/quad_tree_fast.h"
+#include "../QuadTree/quad_tree_moderate.h"
+#include "../QuadTree/quad_tree_orthant.h"
+#include "../QuadTree/quad_tree_parallel.h"
+#include <set>
+#include <thread>
 
 template <typename T>
 class QuadTreeTest : public ::testing::Test {};
@@ -102,5 +107,284 @@ TYPED_TEST(QuadTreeTest, setElements2Arg){
     EXPECT_TRUE(overlappingElements.at(1)->aabb == element0.aabb || overlappingElements.at(1)->aabb == element1.aabb);
     EXPECT_FALSE(overlappingElements.at(0)->aabb == overlappingElements.at(1)->aabb);}
 
+TYPED_TEST(QuadTreeTest, getStats){
+    using EL = QuadTreeElement<TypeParam>;
+    std::vector<EL> vecEL {
+    EL(AABB<TypeParam>(10 , 10, 20, 20)),
+    EL(AABB<TypeParam>(60 , 10, 70, 20)),
+    EL(AABB<TypeParam>(10 , 60, 20, 70)),
+    EL(AABB<TypeParam>(60 , 60, 70, 70)),
+    EL(AABB<TypeParam>(45 , 45, 55, 55))};
+    std::vector<EL*> vecELptrs;
+    for(auto &el: vecEL){
+        vecELptrs.push_back(&el);
+    }
+    auto quadTree = new QuadTreeFast<TypeParam>(vecELptrs, AABB<TypeParam>(0,0,100,100),6,2);
+    auto stats = quadTree->getStats();
+    EXPECT_EQ(stats.nodesNumber,5);
+    EXPECT_EQ(stats.leavesNumber,4);
+    EXPECT_EQ(stats.elementReferencesNumber,8);
+    EXPECT_EQ(stats.leafQuantizationBits,QUAD_TREE_LEAF_QUANTIZATION_BITS);
+}
+
+//Elements covering nested internal nodes must be paired with each other, not only with leaf elements
+TYPED_TEST(QuadTreeTest, nestedCoveringElements){
+    using EL = QuadTreeElement<TypeParam>;
+    std::vector<EL> vecEL {
+    EL(AABB<TypeParam>(0  ,  0,100,100)),
+    EL(AABB<TypeParam>(50 , 50,100,100)),
+    EL(AABB<TypeParam>(60 , 60, 70, 70)),
+    EL(AABB<TypeParam>(80 , 80, 90, 90))};
+    std::vector<EL*> vecELptrs;
+    for(auto &el: vecEL){
+        vecELptrs.push_back(&el);
+    }
+    QuadTreeFast<TypeParam> quadTree(vecELptrs, AABB<TypeParam>(0,0,100,100),3,1);
+    std::set<std::pair<EL*,EL*>> pairs;
+    for(auto &tuple: quadTree.getAllOverlappingElementTuples()){
+        EL* element0 = std::get<0>(tuple);
+        EL* element1 = std::get<1>(tuple);
+        pairs.insert(element0 < element1 ? std::make_pair(element0,element1) : std::make_pair(element1,element0));
+    }
+    EXPECT_EQ(pairs.size(),5);
+    EXPECT_EQ(pairs.count(std::make_pair(vecELptrs.at(0),vecELptrs.at(1))),1);
+}
+
+TYPED_TEST(QuadTreeTest, getElementsThatOverlap){
+    using EL = QuadTreeElement<TypeParam>;
+    std::vector<EL> vecEL {
+    EL(AABB<TypeParam>(10 , 10, 20, 20)),
+    EL(AABB<TypeParam>(60 , 10, 70, 20)),
+    EL(AABB<TypeParam>(10 , 60, 20, 70)),
+    EL(AABB<TypeParam>(60 , 60, 70, 70)),
+    EL(AABB<TypeParam>(0 ,  0, 100, 100))};
+    std::vector<EL*> vecELptrs;
+    for(auto &el: vecEL){
+        vecELptrs.push_back(&el);
+    }
+    QuadTreeFast<TypeParam> quadTree(vecELptrs, AABB<TypeParam>(0,0,100,100),6,2);
+    EXPECT_EQ(quadTree.getElementsThatOverlap(AABB<TypeParam>(15,15,65,65)).size(),5);
+    EXPECT_EQ(quadTree.getElementsThatOverlap(AABB<TypeParam>(30,30,40,40)).size(),1);
+    EXPECT_EQ(quadTree.getElementsThatOverlap(AABB<TypeParam>(55,5,65,15)).size(),2);
+}
+
+TYPED_TEST(QuadTreeTest, getOverlappingTuplesWithOtherTree){
+    using EL = QuadTreeElement<TypeParam>;
+    auto makeElements = [](int number){
+        std::vector<EL> vecEL;
+        for(int i=0;i<number;i++){
+            TypeParam x = rand()%950;
+            TypeParam y = rand()%950;
+            vecEL.push_back(EL(AABB<TypeParam>(x,y,x+1+rand()%50,y+1+rand()%50)));
+        }
+        return vecEL;
+    };
+    auto getPointers = [](std::vector<EL> &vecEL){
+        std::vector<EL*> vecELptrs;
+        for(auto &el: vecEL){
+            vecELptrs.push_back(&el);
+        }
+        return vecELptrs;
+    };
+    std::vector<EL> vecELA = makeElements(400);
+    std::vector<EL> vecELB = makeElements(300);
+    std::vector<EL*> vecELptrsA = getPointers(vecELA);
+    std::vector<EL*> vecELptrsB = getPointers(vecELB);
+    std::set<std::pair<EL*,EL*>> expectedPairs;
+    for(auto elementA: vecELptrsA){
+        for(auto elementB: vecELptrsB){
+            if(elementA->doesOverlap(*elementB)){
+                expectedPairs.insert(std::make_pair(elementA,elementB));
+            }
+        }
+    }
+    auto checkTuples = [&](const vector<tuple<EL*,EL*>> &tuples){
+        std::set<std::pair<EL*,EL*>> pairs;
+        for(auto &tuple: tuples){
+            pairs.insert(std::make_pair(std::get<0>(tuple),std::get<1>(tuple)));
+        }
+        EXPECT_EQ(tuples.size(),pairs.size());
+        EXPECT_TRUE(pairs == expectedPairs);
+    };
+
+    //Same root, elements stick out of its max side but always overlap it
+    QuadTreeFast<TypeParam> quadTreeA(vecELptrsA, AABB<TypeParam>(0,0,960,960),6,4);
+    QuadTreeFast<TypeParam> quadTreeB(vecELptrsB, AABB<TypeParam>(0,0,960,960),6,4);
+    checkTuples(quadTreeA.getOverlappingTuples(quadTreeB));
+
+    //Different roots and depths
+    QuadTreeFast<TypeParam> quadTreeC(vecELptrsB, AABB<TypeParam>(0,0,1500,1200),4,2);
+    checkTuples(quadTreeA.getOverlappingTuples(quadTreeC));
+
+    //Other backend is queried element by element
+    QuadTreeModerate<TypeParam> quadTreeModerate(vecELptrsB, AABB<TypeParam>(0,0,1000,1000));
+    checkTuples(quadTreeA.getOverlappingTuples(quadTreeModerate));
+
+    QuadTreeFast<TypeParam> emptyQuadTree;
+    EXPECT_EQ(quadTreeA.getOverlappingTuples(emptyQuadTree).size(),0);
+}
+
+//Integral trees with power of two root are split with shifts and center comparisons, result must match generic split
+TYPED_TEST(QuadTreeTest, powerOfTwoRootMatchesGenericSplit){
+    using EL = QuadTreeElement<TypeParam>;
+    std::vector<EL> vecEL;
+    for(int i=0;i<2000;i++){
+        //Some elements stick out of the root and some are completly outside of it
+        TypeParam x = rand()%1100;
+        TypeParam y = rand()%1100;
+        vecEL.push_back(EL(AABB<TypeParam>(x,y,x+1+rand()%50,y+1+rand()%50)));
+    }
+    vecEL.push_back(EL(AABB<TypeParam>(0,0,1024,1024)));
+    std::vector<EL*> vecELptrs;
+    for(auto &el: vecEL){
+        vecELptrs.push_back(&el);
+    }
+    for(int depth: {4,12}){
+        QuadTreeFast<TypeParam> quadTree(vecELptrs, AABB<TypeParam>(0,0,1024,1024), depth, 4);
+        QuadTreeFast<TypeParam> genericSplitQuadTree;
+        genericSplitQuadTree.setPowerOfTwoSplit(false);
+        genericSplitQuadTree.setElements(vecELptrs, AABB<TypeParam>(0,0,1024,1024), depth, 4);
+        EXPECT_EQ(quadTree.getAllOverlappingElementTuples(),genericSplitQuadTree.getAllOverlappingElementTuples());
+        EXPECT_EQ(quadTree.getStats().nodesNumber,genericSplitQuadTree.getStats().nodesNumber);
+        EXPECT_EQ(quadTree.getStats().elementReferencesNumber,genericSplitQuadTree.getStats().elementReferencesNumber);
+    }
+}
+
+TYPED_TEST(QuadTreeTest, queryStats){
+    using EL = QuadTreeElement<TypeParam>;
+    std::vector<EL> vecEL;
+    for(int i=0;i<800;i++){
+        TypeParam x = rand()%750;
+        TypeParam y = rand()%750;
+        vecEL.push_back(EL(AABB<TypeParam>(x,y,x+1+rand()%50,y+1+rand()%50)));
+    }
+    vecEL.push_back(EL(AABB<TypeParam>(0,0,799,799)));
+    std::vector<EL*> vecELptrs;
+    for(auto &element: vecEL){
+        vecELptrs.push_back(&element);
+    }
+    QuadTreeFast<TypeParam> quadTreeFast(vecELptrs, AABB<TypeParam>(0,0,799,799), 6, 4);
+    QuadTreeModerate<TypeParam> quadTreeModerate(vecELptrs, AABB<TypeParam>(0,0,799,799), 6, 4);
+    for(QuadTree<TypeParam> *quadTree: {(QuadTree<TypeParam>*) &quadTreeFast, (QuadTree<TypeParam>*) &quadTreeModerate}){
+        auto tuples = quadTree->getAllOverlappingElementTuples();
+        QuadTreeQueryStats stats = quadTree->getQueryStats();
+        if(QUAD_TREE_QUERY_COUNTERS){
+            EXPECT_EQ(stats.emittedPairs,tuples.size());
+            EXPECT_EQ(stats.nodesVisited,quadTree->getStats().nodesNumber);
+            EXPECT_GE(stats.candidatePairs + stats.ancestorPairs,stats.emittedPairs);
+        }else{
+            EXPECT_EQ(stats.nodesVisited,0);
+            EXPECT_EQ(stats.emittedPairs,0);
+        }
+        quadTree->resetQueryStats();
+        EXPECT_EQ(quadTree->getQueryStats().emittedPairs,0);
+    }
+    if(QUAD_TREE_QUERY_COUNTERS){
+        quadTreeFast.getAllOverlappingElementTuples();
+        //Root covering element is paired with everything without test
+        EXPECT_GE(quadTreeFast.getQueryStats().ancestorPairs,vecEL.size() - 1);
+    }
+    //Concurrent const queries add up to the same stats as the same queries made one after another
+    for(QuadTree<TypeParam> *quadTree: {(QuadTree<TypeParam>*) &quadTreeFast, (QuadTree<TypeParam>*) &quadTreeModerate}){
+        quadTree->resetQueryStats();
+        quadTree->getAllOverlappingElementTuples();
+        QuadTreeQueryStats singleQueryStats = quadTree->getQueryStats();
+        quadTree->resetQueryStats();
+        std::vector<std::thread> threads;
+        for(int i=0;i<4;i++){
+            threads.push_back(std::thread([quadTree](){
+                for(int j=0;j<5;j++) quadTree->getAllOverlappingElementTuples();
+            }));
+        }
+        for(auto &thread: threads) thread.join();
+        EXPECT_EQ(quadTree->getQueryStats().nodesVisited,20*singleQueryStats.nodesVisited);
+        EXPECT_EQ(quadTree->getQueryStats().emittedPairs,20*singleQueryStats.emittedPairs);
+    }
+}
+
+TEST(ParallelForPoolTest, visitsEveryIndexOncePerCall){
+    ParallelForPool pool(4);
+    std::vector<int> visits(10000,0);
+    //The same workers take every call, small ranges stay on calling thread
+    for(int size: {0,1,7,100,10000}){
+        for(int minChunkSize: {1,64}){
+            pool.parallelFor(0,size,[&](int begin, int end){
+                for(int i=begin;i<end;i++){
+                    visits.at(i)++;
+                }
+            },minChunkSize);
+        }
+    }
+    for(int i=0;i<visits.size();i++){
+        EXPECT_EQ(visits.at(i),(i<1)*2 + (i<7)*2 + (i<100)*2 + 2);
+    }
+}
+
+TEST(ParallelRadixSortTest, matchesStableSort){
+    for(int threadsNumber: {1,3,8}){
+        std::vector<uint32_t> keys;
+        std::vector<int> values;
+        for(int i=0;i<5000;i++){
+            keys.push_back(static_cast<uint32_t>(rand()) * 2654435761u % (i % 2 ? 1000u : 0xFFFFFFFFu));
+            values.push_back(i);
+        }
+        std::vector<std::pair<uint32_t,int>> expected;
+        for(int i=0;i<keys.size();i++){
+            expected.push_back(std::make_pair(keys.at(i),values.at(i)));
+        }
+        std::stable_sort(expected.begin(),expected.end(),[](const std::pair<uint32_t,int> &a, const std::pair<uint32_t,int> &b){
+            return a.first < b.first;
+        });
+        ParallelForPool pool(threadsNumber);
+        parallelRadixSort(keys,values,pool);
+        for(int i=0;i<expected.size();i++){
+            EXPECT_EQ(keys.at(i),expected.at(i).first);
+            EXPECT_EQ(values.at(i),expected.at(i).second);
+        }
+    }
+}
+
+TYPED_TEST(QuadTreeTest, hilbertOrderKeepsCallerPointers){
+    using EL = QuadTreeElement<TypeParam>;
+    std::vector<EL> vecEL;
+    for(int i=0;i<1500;i++){
+        TypeParam x = rand()%950;
+        TypeParam y = rand()%950;
+        vecEL.push_back(EL(AABB<TypeParam>(x,y,x+1+rand()%40,y+1+rand()%40)));
+    }
+    std::vector<EL*> vecELptrs;
+    for(auto &element: vecEL){
+        vecELptrs.push_back(&element);
+    }
+    auto canonicalize = [](const vector<tuple<EL*,EL*>> &tuples){
+        std::set<std::pair<EL*,EL*>> pairs;
+        for(auto &tuple: tuples){
+            pairs.insert(std::make_pair(std::min(std::get<0>(tuple),std::get<1>(tuple)),std::max(std::get<0>(tuple),std::get<1>(tuple))));
+        }
+        return pairs;
+    };
+    QuadTreeFast<TypeParam> quadTree(vecELptrs, AABB<TypeParam>(0,0,999,999), 8, 4);
+    QuadTreeFast<TypeParam> hilbertQuadTree;
+    hilbertQuadTree.setHilbertOrder(true,4);
+    hilbertQuadTree.setElements(vecELptrs, AABB<TypeParam>(0,0,999,999), 8, 4);
+    EXPECT_EQ(canonicalize(quadTree.getAllOverlappingElementTuples()),canonicalize(hilbertQuadTree.getAllOverlappingElementTuples()));
+    auto overlapping = quadTree.getElementsThatOverlap(AABB<TypeParam>(100,100,300,300));
+    auto hilbertOverlapping = hilbertQuadTree.getElementsThatOverlap(AABB<TypeParam>(100,100,300,300));
+    EXPECT_EQ(std::set<EL*>(overlapping.begin(),overlapping.end()),std::set<EL*>(hilbertOverlapping.begin(),hilbertOverlapping.end()));
+
+    //Order is a permutation of input and consecutive elements are close to each other
+    const vector<int> &order = hilbertQuadTree.getElementsOrder();
+    ASSERT_EQ(order.size(),vecEL.size());
+    EXPECT_EQ(std::set<int>(order.begin(),order.end()).size(),vecEL.size());
+    double inputDistance = 0, hilbertDistance = 0;
+    for(int i=1;i<vecEL.size();i++){
+        auto distance = [&](int a, int b){
+            return std::abs((double) vecEL.at(a).aabb.xMin - vecEL.at(b).aabb.xMin) + std::abs((double) vecEL.at(a).aabb.yMin - vecEL.at(b).aabb.yMin);
+        };
+        inputDistance += distance(i-1,i);
+        hilbertDistance += distance(order.at(i-1),order.at(i));
+    }
+    EXPECT_LT(hilbertDistance * 10, inputDistance);
+}
 
 #endif // QUAD_TREE_TEST_H
@@ -0,0 +1,91 @@
+#ifndef STR_TREE_TEST_H
+#define STR_TREE_TEST_H
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+#include <set>
+
+#include "../QuadTree/quad_tree.h"
+#include "../QuadTree/quad_tree_str.h"
+
+template <typename T>
+class STRTreeTest : public ::testing::Test {};
+using STRTreeTypes = ::testing::Types<int, unsigned int,double>;
+TYPED_TEST_SUITE(STRTreeTest, STRTreeTypes);
+
+TYPED_TEST(STRTreeTest, setElements0Arg){
+    using EL = QuadTreeElement<TypeParam>;
+    std::vector<EL*> vec0EL;
+    STRTree<TypeParam> tree;
+    tree.setElements(vec0EL, AABB<TypeParam>(0,0,100,100));
+    EXPECT_TRUE(tree.getAllOverlappingElements().size()==0);
+    EXPECT_TRUE(tree.getAllOverlappingElementTuples().size()==0);
+    EXPECT_TRUE(tree.getElementsThatOverlap(AABB<TypeParam>(0,0,100,100)).size()==0);
+}
+
+TYPED_TEST(STRTreeTest, setElements2Arg){
+    using EL = QuadTreeElement<TypeParam>;
+    EL element0(AABB<TypeParam>(0,0,10,10));
+    EL element1(AABB<TypeParam>(0,0,11,11));
+    std::vector<EL*> vec2EL {&element0,&element1};
+    STRTree<TypeParam> tree;
+    tree.setElements(vec2EL, AABB<TypeParam>(0,0,100,100));
+    EXPECT_EQ(tree.getAllOverlappingElements().size(),2);
+    EXPECT_EQ(tree.getAllOverlappingElementTuples().size(),1);
+}
+
+TYPED_TEST(STRTreeTest, matchesBruteForce){
+    using EL = QuadTreeElement<TypeParam>;
+    std::vector<EL> vecEL;
+    for(int i=0;i<500;i++){
+        TypeParam x = rand()%950;
+        TypeParam y = rand()%950;
+        vecEL.push_back(EL(AABB<TypeParam>(x,y,x+1+rand()%50,y+1+rand()%50)));
+    }
+    std::vector<EL*> vecELptrs;
+    for(auto &el: vecEL){
+        vecELptrs.push_back(&el);
+    }
+    auto orderedPair = [](EL* a, EL* b){
+        return a < b ? std::make_pair(a,b) : std::make_pair(b,a);
+    };
+    std::set<std::pair<EL*,EL*>> expectedPairs;
+    for(int i=0;i<vecELptrs.size();i++){
+        for(int j=i+1;j<vecELptrs.size();j++){
+            if(vecELptrs.at(i)->doesOverlap(*vecELptrs.at(j))){
+                expectedPairs.insert(orderedPair(vecELptrs.at(i),vecELptrs.at(j)));
+            }
+        }
+    }
+    for(int fanOut: {2,4,16}){
+        STRTree<TypeParam> tree(vecELptrs,fanOut);
+        auto tuples = tree.getAllOverlappingElementTuples();
+        std::set<std::pair<EL*,EL*>> pairs;
+        for(auto &tuple: tuples){
+            pairs.insert(orderedPair(std::get<0>(tuple),std::get<1>(tuple)));
+        }
+        EXPECT_EQ(tuples.size(),expectedPairs.size());
+        EXPECT_TRUE(pairs == expectedPairs);
+        EXPECT_EQ(tree.getStats().elementReferencesNumber,vecEL.size());
+    }
+}
+
+TYPED_TEST(STRTreeTest, getElementsThatOverlap){
+    using EL = QuadTreeElement<TypeParam>;
+    std::vector<EL> vecEL;
+    for(int i=0;i<10;i++){
+        for(int j=0;j<10;j++){
+            vecEL.push_back(EL(AABB<TypeParam>(i*10,j*10,i*10+5,j*10+5)));
+        }
+    }
+    std::vector<EL*> vecELptrs;
+    for(auto &el: vecEL){
+        vecELptrs.push_back(&el);
+    }
+    STRTree<TypeParam> tree(vecELptrs,4);
+    EXPECT_EQ(tree.getElementsThatOverlap(AABB<TypeParam>(0,0,100,100)).size(),100);
+    EXPECT_EQ(tree.getElementsThatOverlap(AABB<TypeParam>(12,12,28,28)).size(),4);
+    EXPECT_EQ(tree.getElementsThatOverlap(AABB<TypeParam>(6,6,9,9)).size(),0);
+    EXPECT_EQ(tree.getAllOverlappingElementTuples().size(),0);
+}
+
+#endif // STR_TREE_TEST_H